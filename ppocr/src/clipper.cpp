@@ -58,6 +58,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <functional>
+#include <new>
 #include <ostream>
 #include <stdexcept>
 #include <vector>
@@ -184,6 +185,83 @@ int PolyTree::Total() const {
   return result;
 }
 
+//------------------------------------------------------------------------------
+// ClipperArena methods ...
+//------------------------------------------------------------------------------
+
+ClipperArena::ClipperArena() : m_block(0), m_used(0) {
+  std::memset(m_freeNodes, 0, sizeof(m_freeNodes));
+}
+//------------------------------------------------------------------------------
+
+ClipperArena::~ClipperArena() {
+  for (size_t i = 0; i < m_blocks.size(); ++i)
+    std::free(m_blocks[i]);
+}
+//------------------------------------------------------------------------------
+
+void *ClipperArena::Allocate(size_t bytes) {
+  bytes = (bytes + kAlign - 1) / kAlign * kAlign;
+  while (m_block < m_blocks.size()) {
+    if (m_used + bytes <= m_blockSizes[m_block]) {
+      void *result = m_blocks[m_block] + m_used;
+      m_used += bytes;
+      return result;
+    }
+    ++m_block;
+    m_used = 0;
+  }
+  size_t size = std::max<size_t>(kBlockSize, bytes);
+  char *block = static_cast<char *>(std::malloc(size));
+  if (!block)
+    throw std::bad_alloc();
+  m_blocks.push_back(block);
+  m_blockSizes.push_back(size);
+  m_block = m_blocks.size() - 1;
+  m_used = bytes;
+  return block;
+}
+//------------------------------------------------------------------------------
+
+void *ClipperArena::AllocateNode(size_t bytes) {
+  size_t cls = (bytes + kAlign - 1) / kAlign;
+  if (cls < kNodeClasses && m_freeNodes[cls]) {
+    void *node = m_freeNodes[cls];
+    std::memcpy(&m_freeNodes[cls], node, sizeof(void *));
+    return node;
+  }
+  return Allocate(bytes);
+}
+//------------------------------------------------------------------------------
+
+void ClipperArena::FreeNode(void *node, size_t bytes) {
+  size_t cls = (bytes + kAlign - 1) / kAlign;
+  if (cls >= kNodeClasses)
+    return; // reclaimed by Reset()
+  std::memcpy(node, &m_freeNodes[cls], sizeof(void *));
+  m_freeNodes[cls] = node;
+}
+//------------------------------------------------------------------------------
+
+void ClipperArena::Reset() {
+  m_block = 0;
+  m_used = 0;
+  std::memset(m_freeNodes, 0, sizeof(m_freeNodes));
+}
+//------------------------------------------------------------------------------
+
+// Clipper's node structs are trivially destructible, so releasing a node is
+// just returning its storage to the arena.
+template <class T> inline T *NewNode(ClipperArena &arena) {
+  return new (arena.AllocateNode(sizeof(T))) T;
+}
+//------------------------------------------------------------------------------
+
+template <class T> inline void DeleteNode(ClipperArena &arena, T *node) {
+  arena.FreeNode(node, sizeof(T));
+}
+//------------------------------------------------------------------------------
+
 //------------------------------------------------------------------------------
 // PolyNode methods ...
 //------------------------------------------------------------------------------
@@ -669,14 +747,14 @@ void ReversePolyPtLinks(OutPt *pp) {
 }
 //------------------------------------------------------------------------------
 
-void DisposeOutPts(OutPt *&pp) {
+void DisposeOutPts(OutPt *&pp, ClipperArena &arena) {
   if (pp == 0)
     return;
   pp->Prev->Next = 0;
   while (pp) {
     OutPt *tmpPp = pp;
     pp = pp->Next;
-    delete tmpPp;
+    DeleteNode(arena, tmpPp);
   }
 }
 //------------------------------------------------------------------------------
@@ -1024,7 +1102,8 @@ bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed) {
     return false;
 
   // create a new edge array ...
-  TEdge *edges = new TEdge[highI + 1];
+  TEdge *edges = static_cast<TEdge *>(
+      m_edgeArena.Allocate(sizeof(TEdge) * (highI + 1)));
 
   bool IsFlat = true;
   // 1. Basic (first) edge initialization ...
@@ -1039,7 +1118,7 @@ bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed) {
       InitEdge(&edges[i], &edges[i + 1], &edges[i - 1], pg[i]);
     }
   } catch (...) {
-    delete[] edges;
+    // edges stay in m_edgeArena until Clear()
     throw; // range test fails
   }
   TEdge *eStart = &edges[0];
@@ -1080,7 +1159,7 @@ bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed) {
   }
 
   if ((!Closed && (E == E->Next)) || (Closed && (E->Prev == E->Next))) {
-    delete[] edges;
+    // edges stay in m_edgeArena until Clear()
     return false;
   }
 
@@ -1104,7 +1183,7 @@ bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed) {
   // to LocalMinima list to avoid endless loops etc ...
   if (IsFlat) {
     if (Closed) {
-      delete[] edges;
+      // edges stay in m_edgeArena until Clear()
       return false;
     }
     E->Prev->OutIdx = Skip;
@@ -1196,11 +1275,8 @@ bool ClipperBase::AddPaths(const Paths &ppg, PolyType PolyTyp, bool Closed) {
 
 void ClipperBase::Clear() {
   DisposeLocalMinimaList();
-  for (EdgeList::size_type i = 0; i < m_edges.size(); ++i) {
-    TEdge *edges = m_edges[i];
-    delete[] edges;
-  }
   m_edges.clear();
+  m_edgeArena.Reset();
   m_UseFullRange = false;
   m_HasOpenPaths = false;
 }
@@ -1212,7 +1288,9 @@ void ClipperBase::Reset() {
     return; // ie nothing to process
   std::sort(m_MinimaList.begin(), m_MinimaList.end(), LocMinSorter());
 
-  m_Scanbeam = ScanbeamList(); // clears/resets priority_queue
+  // clear the priority_queue but keep its storage
+  while (!m_Scanbeam.empty())
+    m_Scanbeam.pop();
   // reset all edges ...
   for (MinimaList::iterator lm = m_MinimaList.begin(); lm != m_MinimaList.end();
        ++lm) {
@@ -1310,14 +1388,17 @@ void ClipperBase::DisposeAllOutRecs() {
   for (PolyOutList::size_type i = 0; i < m_PolyOuts.size(); ++i)
     DisposeOutRec(i);
   m_PolyOuts.clear();
+  // every node of this Execute is gone now (joins and intersections are
+  // released while it runs), so the whole node arena can be rewound.
+  m_nodeArena.Reset();
 }
 //------------------------------------------------------------------------------
 
 void ClipperBase::DisposeOutRec(PolyOutList::size_type index) {
   OutRec *outRec = m_PolyOuts[index];
   if (outRec->Pts)
-    DisposeOutPts(outRec->Pts);
-  delete outRec;
+    DisposeOutPts(outRec->Pts, m_nodeArena);
+  DeleteNode(m_nodeArena, outRec);
   m_PolyOuts[index] = 0;
 }
 //------------------------------------------------------------------------------
@@ -1339,7 +1420,7 @@ void ClipperBase::DeleteFromAEL(TEdge *e) {
 //------------------------------------------------------------------------------
 
 OutRec *ClipperBase::CreateOutRec() {
-  OutRec *result = new OutRec;
+  OutRec *result = NewNode<OutRec>(m_nodeArena);
   result->IsHole = false;
   result->IsOpen = false;
   result->FirstLeft = 0;
@@ -1478,7 +1559,6 @@ bool Clipper::Execute(ClipType clipType, Paths &solution,
     throw clipperException(
         "Error: PolyTree struct is needed for open path clipping.");
   m_ExecuteLocked = true;
-  solution.resize(0);
   m_SubjFillType = subjFillType;
   m_ClipFillType = clipFillType;
   m_ClipType = clipType;
@@ -1486,6 +1566,8 @@ bool Clipper::Execute(ClipType clipType, Paths &solution,
   bool succeeded = ExecuteInternal();
   if (succeeded)
     BuildResult(solution);
+  else
+    solution.resize(0);
   DisposeAllOutRecs();
   m_ExecuteLocked = false;
   return succeeded;
@@ -1871,7 +1953,7 @@ void Clipper::CopyAELToSEL() {
 //------------------------------------------------------------------------------
 
 void Clipper::AddJoin(OutPt *op1, OutPt *op2, const IntPoint OffPt) {
-  Join *j = new Join;
+  Join *j = NewNode<Join>(m_nodeArena);
   j->OutPt1 = op1;
   j->OutPt2 = op2;
   j->OffPt = OffPt;
@@ -1881,20 +1963,20 @@ void Clipper::AddJoin(OutPt *op1, OutPt *op2, const IntPoint OffPt) {
 
 void Clipper::ClearJoins() {
   for (JoinList::size_type i = 0; i < m_Joins.size(); i++)
-    delete m_Joins[i];
+    DeleteNode(m_nodeArena, m_Joins[i]);
   m_Joins.resize(0);
 }
 //------------------------------------------------------------------------------
 
 void Clipper::ClearGhostJoins() {
   for (JoinList::size_type i = 0; i < m_GhostJoins.size(); i++)
-    delete m_GhostJoins[i];
+    DeleteNode(m_nodeArena, m_GhostJoins[i]);
   m_GhostJoins.resize(0);
 }
 //------------------------------------------------------------------------------
 
 void Clipper::AddGhostJoin(OutPt *op, const IntPoint OffPt) {
-  Join *j = new Join;
+  Join *j = NewNode<Join>(m_nodeArena);
   j->OutPt1 = op;
   j->OutPt2 = 0;
   j->OffPt = OffPt;
@@ -2371,7 +2453,7 @@ OutPt *Clipper::AddOutPt(TEdge *e, const IntPoint &pt) {
   if (e->OutIdx < 0) {
     OutRec *outRec = CreateOutRec();
     outRec->IsOpen = (e->WindDelta == 0);
-    OutPt *newOp = new OutPt;
+    OutPt *newOp = NewNode<OutPt>(m_nodeArena);
     outRec->Pts = newOp;
     newOp->Idx = outRec->Idx;
     newOp->Pt = pt;
@@ -2392,7 +2474,7 @@ OutPt *Clipper::AddOutPt(TEdge *e, const IntPoint &pt) {
     else if (!ToFront && (pt == op->Prev->Pt))
       return op->Prev;
 
-    OutPt *newOp = new OutPt;
+    OutPt *newOp = NewNode<OutPt>(m_nodeArena);
     newOp->Idx = outRec->Idx;
     newOp->Pt = pt;
     newOp->Next = op;
@@ -2735,7 +2817,7 @@ bool Clipper::ProcessIntersections(const cInt topY) {
 
 void Clipper::DisposeIntersectNodes() {
   for (size_t i = 0; i < m_IntersectList.size(); ++i)
-    delete m_IntersectList[i];
+    DeleteNode(m_nodeArena, m_IntersectList[i]);
   m_IntersectList.clear();
 }
 //------------------------------------------------------------------------------
@@ -2766,7 +2848,7 @@ void Clipper::BuildIntersectList(const cInt topY) {
         IntersectPoint(*e, *eNext, Pt);
         if (Pt.Y < topY)
           Pt = IntPoint(TopX(*e, topY), topY);
-        IntersectNode *newNode = new IntersectNode;
+        IntersectNode *newNode = NewNode<IntersectNode>(m_nodeArena);
         newNode->Edge1 = e;
         newNode->Edge2 = eNext;
         newNode->Pt = Pt;
@@ -2793,7 +2875,7 @@ void Clipper::ProcessIntersectList() {
       IntersectEdges(iNode->Edge1, iNode->Edge2, iNode->Pt);
       SwapPositionsInAEL(iNode->Edge1, iNode->Edge2);
     }
-    delete iNode;
+    DeleteNode(m_nodeArena, iNode);
   }
   m_IntersectList.clear();
 }
@@ -2985,13 +3067,13 @@ void Clipper::FixupOutPolyline(OutRec &outrec) {
       OutPt *tmpPP = pp->Prev;
       tmpPP->Next = pp->Next;
       pp->Next->Prev = tmpPP;
-      delete pp;
+      DeleteNode(m_nodeArena, pp);
       pp = tmpPP;
     }
   }
 
   if (pp == pp->Prev) {
-    DisposeOutPts(pp);
+    DisposeOutPts(pp, m_nodeArena);
     outrec.Pts = 0;
     return;
   }
@@ -3008,7 +3090,7 @@ void Clipper::FixupOutPolygon(OutRec &outrec) {
 
   for (;;) {
     if (pp->Prev == pp || pp->Prev == pp->Next) {
-      DisposeOutPts(pp);
+      DisposeOutPts(pp, m_nodeArena);
       outrec.Pts = 0;
       return;
     }
@@ -3023,7 +3105,7 @@ void Clipper::FixupOutPolygon(OutRec &outrec) {
       pp->Prev->Next = pp->Next;
       pp->Next->Prev = pp->Prev;
       pp = pp->Prev;
-      delete tmp;
+      DeleteNode(m_nodeArena, tmp);
     } else if (pp == lastOK)
       break;
     else {
@@ -3050,22 +3132,27 @@ int PointCount(OutPt *Pts) {
 //------------------------------------------------------------------------------
 
 void Clipper::BuildResult(Paths &polys) {
-  polys.reserve(m_PolyOuts.size());
+  // overwrite the paths already in polys so a reused solution keeps its
+  // storage, then drop whatever is left over
+  Paths::size_type used = 0;
   for (PolyOutList::size_type i = 0; i < m_PolyOuts.size(); ++i) {
     if (!m_PolyOuts[i]->Pts)
       continue;
-    Path pg;
     OutPt *p = m_PolyOuts[i]->Pts->Prev;
     int cnt = PointCount(p);
     if (cnt < 2)
       continue;
+    if (used == polys.size())
+      polys.push_back(Path());
+    Path &pg = polys[used++];
+    pg.clear();
     pg.reserve(cnt);
     for (int i = 0; i < cnt; ++i) {
       pg.push_back(p->Pt);
       p = p->Prev;
     }
-    polys.push_back(pg);
   }
+  polys.resize(used);
 }
 //------------------------------------------------------------------------------
 
@@ -3190,8 +3277,8 @@ void Clipper::InsertEdgeIntoAEL(TEdge *edge, TEdge *startEdge) {
 }
 //----------------------------------------------------------------------
 
-OutPt *DupOutPt(OutPt *outPt, bool InsertAfter) {
-  OutPt *result = new OutPt;
+OutPt *DupOutPt(OutPt *outPt, bool InsertAfter, ClipperArena &arena) {
+  OutPt *result = NewNode<OutPt>(arena);
   result->Pt = outPt->Pt;
   result->Idx = outPt->Idx;
   if (InsertAfter) {
@@ -3210,7 +3297,7 @@ OutPt *DupOutPt(OutPt *outPt, bool InsertAfter) {
 //------------------------------------------------------------------------------
 
 bool JoinHorz(OutPt *op1, OutPt *op1b, OutPt *op2, OutPt *op2b,
-              const IntPoint Pt, bool DiscardLeft) {
+              const IntPoint Pt, bool DiscardLeft, ClipperArena &arena) {
   Direction Dir1 = (op1->Pt.X > op1b->Pt.X ? dRightToLeft : dLeftToRight);
   Direction Dir2 = (op2->Pt.X > op2b->Pt.X ? dRightToLeft : dLeftToRight);
   if (Dir1 == Dir2)
@@ -3227,11 +3314,11 @@ bool JoinHorz(OutPt *op1, OutPt *op1b, OutPt *op2, OutPt *op2b,
       op1 = op1->Next;
     if (DiscardLeft && (op1->Pt.X != Pt.X))
       op1 = op1->Next;
-    op1b = DupOutPt(op1, !DiscardLeft);
+    op1b = DupOutPt(op1, !DiscardLeft, arena);
     if (op1b->Pt != Pt) {
       op1 = op1b;
       op1->Pt = Pt;
-      op1b = DupOutPt(op1, !DiscardLeft);
+      op1b = DupOutPt(op1, !DiscardLeft, arena);
     }
   } else {
     while (op1->Next->Pt.X >= Pt.X && op1->Next->Pt.X <= op1->Pt.X &&
@@ -3239,11 +3326,11 @@ bool JoinHorz(OutPt *op1, OutPt *op1b, OutPt *op2, OutPt *op2b,
       op1 = op1->Next;
     if (!DiscardLeft && (op1->Pt.X != Pt.X))
       op1 = op1->Next;
-    op1b = DupOutPt(op1, DiscardLeft);
+    op1b = DupOutPt(op1, DiscardLeft, arena);
     if (op1b->Pt != Pt) {
       op1 = op1b;
       op1->Pt = Pt;
-      op1b = DupOutPt(op1, DiscardLeft);
+      op1b = DupOutPt(op1, DiscardLeft, arena);
     }
   }
 
@@ -3253,11 +3340,11 @@ bool JoinHorz(OutPt *op1, OutPt *op1b, OutPt *op2, OutPt *op2b,
       op2 = op2->Next;
     if (DiscardLeft && (op2->Pt.X != Pt.X))
       op2 = op2->Next;
-    op2b = DupOutPt(op2, !DiscardLeft);
+    op2b = DupOutPt(op2, !DiscardLeft, arena);
     if (op2b->Pt != Pt) {
       op2 = op2b;
       op2->Pt = Pt;
-      op2b = DupOutPt(op2, !DiscardLeft);
+      op2b = DupOutPt(op2, !DiscardLeft, arena);
     };
   } else {
     while (op2->Next->Pt.X >= Pt.X && op2->Next->Pt.X <= op2->Pt.X &&
@@ -3265,11 +3352,11 @@ bool JoinHorz(OutPt *op1, OutPt *op1b, OutPt *op2, OutPt *op2b,
       op2 = op2->Next;
     if (!DiscardLeft && (op2->Pt.X != Pt.X))
       op2 = op2->Next;
-    op2b = DupOutPt(op2, DiscardLeft);
+    op2b = DupOutPt(op2, DiscardLeft, arena);
     if (op2b->Pt != Pt) {
       op2 = op2b;
       op2->Pt = Pt;
-      op2b = DupOutPt(op2, DiscardLeft);
+      op2b = DupOutPt(op2, DiscardLeft, arena);
     };
   };
 
@@ -3318,8 +3405,8 @@ bool Clipper::JoinPoints(Join *j, OutRec *outRec1, OutRec *outRec2) {
     if (reverse1 == reverse2)
       return false;
     if (reverse1) {
-      op1b = DupOutPt(op1, false);
-      op2b = DupOutPt(op2, true);
+      op1b = DupOutPt(op1, false, m_nodeArena);
+      op2b = DupOutPt(op2, true, m_nodeArena);
       op1->Prev = op2;
       op2->Next = op1;
       op1b->Next = op2b;
@@ -3328,8 +3415,8 @@ bool Clipper::JoinPoints(Join *j, OutRec *outRec1, OutRec *outRec2) {
       j->OutPt2 = op1b;
       return true;
     } else {
-      op1b = DupOutPt(op1, true);
-      op2b = DupOutPt(op2, false);
+      op1b = DupOutPt(op1, true, m_nodeArena);
+      op2b = DupOutPt(op2, false, m_nodeArena);
       op1->Next = op2;
       op2->Prev = op1;
       op1b->Prev = op2b;
@@ -3387,7 +3474,8 @@ bool Clipper::JoinPoints(Join *j, OutRec *outRec1, OutRec *outRec2) {
     }
     j->OutPt1 = op1;
     j->OutPt2 = op2;
-    return JoinHorz(op1, op1b, op2, op2b, Pt, DiscardLeftSide);
+    return JoinHorz(op1, op1b, op2, op2b, Pt, DiscardLeftSide,
+                    m_nodeArena);
   } else {
     // nb: For non-horizontal joins ...
     //    1. Jr.OutPt1.Pt.Y == Jr.OutPt2.Pt.Y
@@ -3426,8 +3514,8 @@ bool Clipper::JoinPoints(Join *j, OutRec *outRec1, OutRec *outRec2) {
       return false;
 
     if (Reverse1) {
-      op1b = DupOutPt(op1, false);
-      op2b = DupOutPt(op2, true);
+      op1b = DupOutPt(op1, false, m_nodeArena);
+      op2b = DupOutPt(op2, true, m_nodeArena);
       op1->Prev = op2;
       op2->Next = op1;
       op1b->Next = op2b;
@@ -3436,8 +3524,8 @@ bool Clipper::JoinPoints(Join *j, OutRec *outRec1, OutRec *outRec2) {
       j->OutPt2 = op1b;
       return true;
     } else {
-      op1b = DupOutPt(op1, true);
-      op2b = DupOutPt(op2, false);
+      op1b = DupOutPt(op1, true, m_nodeArena);
+      op2b = DupOutPt(op2, false, m_nodeArena);
       op1->Next = op2;
       op2->Prev = op1;
       op1b->Prev = op2b;
@@ -3619,15 +3707,20 @@ ClipperOffset::ClipperOffset(double miterLimit, double arcTolerance) {
   this->MiterLimit = miterLimit;
   this->ArcTolerance = arcTolerance;
   m_lowest.X = -1;
+  m_destCount = 0;
 }
 //------------------------------------------------------------------------------
 
-ClipperOffset::~ClipperOffset() { Clear(); }
+ClipperOffset::~ClipperOffset() {
+  Clear();
+  for (PolyNodes::size_type i = 0; i < m_spareNodes.size(); ++i)
+    delete m_spareNodes[i];
+}
 //------------------------------------------------------------------------------
 
 void ClipperOffset::Clear() {
   for (int i = 0; i < m_polyNodes.ChildCount(); ++i)
-    delete m_polyNodes.Childs[i];
+    m_spareNodes.push_back(m_polyNodes.Childs[i]);
   m_polyNodes.Childs.clear();
   m_lowest.X = -1;
 }
@@ -3638,7 +3731,18 @@ void ClipperOffset::AddPath(const Path &path, JoinType joinType,
   int highI = (int)path.size() - 1;
   if (highI < 0)
     return;
-  PolyNode *newNode = new PolyNode();
+  PolyNode *newNode;
+  if (m_spareNodes.empty()) {
+    newNode = new PolyNode();
+  } else {
+    newNode = m_spareNodes.back();
+    m_spareNodes.pop_back();
+    newNode->Contour.clear();
+    newNode->Childs.clear();
+    newNode->Parent = 0;
+    newNode->Index = 0;
+    newNode->m_IsOpen = false;
+  }
   newNode->m_jointype = joinType;
   newNode->m_endtype = endType;
 
@@ -3659,7 +3763,7 @@ void ClipperOffset::AddPath(const Path &path, JoinType joinType,
         k = j;
     }
   if (endType == etClosedPolygon && j < 2) {
-    delete newNode;
+    m_spareNodes.push_back(newNode);
     return;
   }
   m_polyNodes.AddChild(*newNode);
@@ -3707,12 +3811,13 @@ void ClipperOffset::FixOrientations() {
 //------------------------------------------------------------------------------
 
 void ClipperOffset::Execute(Paths &solution, double delta) {
-  solution.clear();
   FixOrientations();
   DoOffset(delta);
 
   // now clean up 'corners' ...
-  Clipper clpr;
+  Clipper &clpr = m_clipper;
+  clpr.Clear();
+  clpr.ReverseSolution(false);
   clpr.AddPaths(m_destPolys, ptSubject, true);
   if (delta > 0) {
     clpr.Execute(ctUnion, solution, pftPositive, pftPositive);
@@ -3739,7 +3844,9 @@ void ClipperOffset::Execute(PolyTree &solution, double delta) {
   DoOffset(delta);
 
   // now clean up 'corners' ...
-  Clipper clpr;
+  Clipper &clpr = m_clipper;
+  clpr.Clear();
+  clpr.ReverseSolution(false);
   clpr.AddPaths(m_destPolys, ptSubject, true);
   if (delta > 0) {
     clpr.Execute(ctUnion, solution, pftPositive, pftPositive);
@@ -3768,8 +3875,24 @@ void ClipperOffset::Execute(PolyTree &solution, double delta) {
 }
 //------------------------------------------------------------------------------
 
+void ClipperOffset::PushDestPoly(const Path &poly) {
+  // assign into an existing slot when there is one so its storage is reused
+  if (m_destCount == m_destPolys.size())
+    m_destPolys.push_back(poly);
+  else
+    m_destPolys[m_destCount] = poly;
+  ++m_destCount;
+}
+//------------------------------------------------------------------------------
+
 void ClipperOffset::DoOffset(double delta) {
-  m_destPolys.clear();
+  DoOffsetInto(delta);
+  m_destPolys.resize(m_destCount);
+}
+//------------------------------------------------------------------------------
+
+void ClipperOffset::DoOffsetInto(double delta) {
+  m_destCount = 0;
   m_delta = delta;
 
   // if Zero offset, just copy any CLOSED polygons to m_p and return ...
@@ -3778,7 +3901,7 @@ void ClipperOffset::DoOffset(double delta) {
     for (int i = 0; i < m_polyNodes.ChildCount(); i++) {
       PolyNode &node = *m_polyNodes.Childs[i];
       if (node.m_endtype == etClosedPolygon)
-        m_destPolys.push_back(node.Contour);
+        PushDestPoly(node.Contour);
     }
     return;
   }
@@ -3840,7 +3963,7 @@ void ClipperOffset::DoOffset(double delta) {
             X = -1;
         }
       }
-      m_destPolys.push_back(m_destPoly);
+      PushDestPoly(m_destPoly);
       continue;
     }
     // build m_normals ...
@@ -3857,12 +3980,12 @@ void ClipperOffset::DoOffset(double delta) {
       int k = len - 1;
       for (int j = 0; j < len; ++j)
         OffsetPoint(j, k, node.m_jointype);
-      m_destPolys.push_back(m_destPoly);
+      PushDestPoly(m_destPoly);
     } else if (node.m_endtype == etClosedLine) {
       int k = len - 1;
       for (int j = 0; j < len; ++j)
         OffsetPoint(j, k, node.m_jointype);
-      m_destPolys.push_back(m_destPoly);
+      PushDestPoly(m_destPoly);
       m_destPoly.clear();
       // re-build m_normals ...
       DoublePoint n = m_normals[len - 1];
@@ -3872,7 +3995,7 @@ void ClipperOffset::DoOffset(double delta) {
       k = 0;
       for (int j = len - 1; j >= 0; j--)
         OffsetPoint(j, k, node.m_jointype);
-      m_destPolys.push_back(m_destPoly);
+      PushDestPoly(m_destPoly);
     } else {
       int k = 0;
       for (int j = 1; j < len - 1; ++j)
@@ -3922,7 +4045,7 @@ void ClipperOffset::DoOffset(double delta) {
         else
           DoRound(0, 1);
       }
-      m_destPolys.push_back(m_destPoly);
+      PushDestPoly(m_destPoly);
     }
   }
 }
@@ -252,6 +252,35 @@ typedef std::vector<IntersectNode *> IntersectList;
 
 //------------------------------------------------------------------------------
 
+// ClipperArena is a block allocator for Clipper's internal nodes (edges,
+// OutRec, OutPt, Join, IntersectNode). Memory is carved from large blocks;
+// small nodes released with FreeNode go on a per-size free list and are
+// handed out again first. Reset() drops everything at once but keeps the
+// blocks, so a Clipper or ClipperOffset that is reused across calls stops
+// touching the heap once its blocks are large enough. Not thread-safe: use
+// one instance (i.e. one Clipper / ClipperOffset) per thread.
+class ClipperArena {
+public:
+  ClipperArena();
+  ~ClipperArena();
+  // bytes of storage, aligned for any Clipper node, valid until Reset().
+  void *Allocate(size_t bytes);
+  void *AllocateNode(size_t bytes);
+  void FreeNode(void *node, size_t bytes);
+  void Reset();
+
+private:
+  ClipperArena(const ClipperArena &);
+  ClipperArena &operator=(const ClipperArena &);
+  enum { kAlign = 16, kBlockSize = 16384, kNodeClasses = 16 };
+  std::vector<char *> m_blocks;
+  std::vector<size_t> m_blockSizes;
+  size_t m_block; // block currently being carved
+  size_t m_used;  // bytes used in m_blocks[m_block]
+  void *m_freeNodes[kNodeClasses];
+};
+//------------------------------------------------------------------------------
+
 // ClipperBase is the ancestor to the Clipper class. It should not be
 // instantiated directly. This class simply abstracts the conversion of sets of
 // polygon coordinates into edge objects that are stored in a LocalMinima list.
@@ -295,6 +324,9 @@ protected:
 
   typedef std::priority_queue<cInt> ScanbeamList;
   ScanbeamList m_Scanbeam;
+
+  ClipperArena m_edgeArena; // TEdge arrays, reset by Clear()
+  ClipperArena m_nodeArena; // output/join/intersect nodes, reset per Execute
 };
 //------------------------------------------------------------------------------
 
@@ -398,12 +430,18 @@ public:
   void AddPaths(const Paths &paths, JoinType joinType, EndType endType);
   void Execute(Paths &solution, double delta);
   void Execute(PolyTree &solution, double delta);
+  // Removes the added paths. The object keeps its internal buffers, so
+  // reusing one ClipperOffset (one per thread) for many small offsets does
+  // no per-call heap allocation once warmed up.
   void Clear();
   double MiterLimit;
   double ArcTolerance;
 
 private:
+  Clipper m_clipper;       // reused for the final union of every Execute
+  PolyNodes m_spareNodes;  // path nodes released by Clear(), reused by AddPath
   Paths m_destPolys;
+  Paths::size_type m_destCount; // paths of m_destPolys in use by DoOffset
   Path m_srcPoly;
   Path m_destPoly;
   std::vector<DoublePoint> m_normals;
@@ -414,6 +452,8 @@ private:
 
   void FixOrientations();
   void DoOffset(double delta);
+  void DoOffsetInto(double delta);
+  void PushDestPoly(const Path &poly);
   void OffsetPoint(int j, int &k, JoinType jointype);
   void DoSquare(int j, int k);
   void DoMiter(int j, int k, double r);
@@ -0,0 +1,420 @@
+#include "ctc_decoder.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ocr {
+
+namespace {
+
+const uint32_t kTrieMagic = 0x4952544f;  // "OTRI"
+const uint32_t kTrieVersion = 1;
+const uint32_t kTrieHeaderWords = 4;
+const uint32_t kTerminalBit = 0x80000000u;
+
+// Một tiền tố của beam search: node trong cây tiền tố (cha + ký tự cuối), node trie tương ứng
+// và thông tin thời gian của ký tự cuối. Con của một node nối thành danh sách liên kết.
+struct PrefixNode {
+    int parent;
+    int label;
+    int trie;
+    int start_step;
+    int end_step;
+    float prob;
+    int first_child;
+    int next_sibling;
+};
+
+// Xác suất (đã chuẩn hóa theo bước) của một tiền tố, tách theo đường kết thúc bằng blank / ký tự.
+struct Beam {
+    int node;
+    float pb;
+    float pnb;
+
+    float total() const { return pb + pnb; }
+};
+
+} // namespace
+
+CharListIndex::CharListIndex(const std::vector<std::string> &char_list) {
+    for (size_t i = 1; i < char_list.size(); i++) {
+        classes_.emplace(char_list[i], static_cast<int>(i));
+        max_len_ = std::max(max_len_, char_list[i].size());
+    }
+}
+
+bool CharListIndex::split(const std::string &text, std::vector<int> &labels) const {
+    labels.clear();
+    for (size_t pos = 0; pos < text.size();) {
+        size_t len = std::min(max_len_, text.size() - pos);
+        for (; len > 0; len--) {
+            auto it = classes_.find(text.substr(pos, len));
+            if (it != classes_.end()) {
+                labels.push_back(it->second);
+                break;
+            }
+        }
+        if (len == 0)
+            return false;
+        pos += len;
+    }
+    return !labels.empty();
+}
+
+void CtcPath::appendStep(const CtcPath &src, size_t t) {
+    index.push_back(src.index[t]);
+    prob.push_back(src.prob[t]);
+    step.push_back(src.step[t]);
+}
+
+void AppendArgmax(const float *probs, int steps, int num_classes, int first_step, CtcPath &path) {
+    const size_t old = path.index.size();
+    path.index.resize(old + steps);
+    path.prob.resize(old + steps);
+    path.step.resize(old + steps);
+    ArgmaxRows(probs, steps, num_classes, path.index.data() + old, path.prob.data() + old);
+    for (int t = 0; t < steps; t++)
+        path.step[old + t] = first_step + t;
+}
+
+DecodeResult CollapsePath(const CtcPath &path, const std::vector<std::string> &char_list) {
+    DecodeResult result;
+    result.confidence = 0.f;
+    const int dict_size = static_cast<int>(char_list.size());
+    size_t bytes = 0, count = 0;
+    int prev_index = -1;
+    for (int index : path.index) {
+        if (index != 0 && index != prev_index && index < dict_size) {
+            bytes += char_list[index].size();
+            count++;
+        }
+        prev_index = index;
+    }
+    result.text.reserve(bytes);
+    result.chars.reserve(count);
+
+    float confidence_sum = 0.f;
+    prev_index = -1;
+    for (size_t i = 0; i < path.index.size(); ++i) {
+        const int index = path.index[i];
+        if (index != 0 && index < dict_size) {
+            if (index != prev_index) {
+                result.text += char_list[index];
+                result.chars.push_back(CharInfo{path.step[i], path.step[i] + 1, path.prob[i]});
+                confidence_sum += path.prob[i];
+            } else {
+                result.chars.back().end_step = path.step[i] + 1;
+            }
+        }
+        prev_index = index;
+    }
+    result.confidence = count > 0 ? confidence_sum / count : 0.f;
+    return result;
+}
+
+bool CtcLattice::isBlank(size_t t) const {
+    for (int k = begin[t]; k < begin[t + 1]; k++) {
+        if (prob[k] > blank[t])
+            return false;
+    }
+    return true;
+}
+
+void CtcLattice::appendStep(const CtcLattice &src, size_t t) {
+    blank.push_back(src.blank[t]);
+    step.push_back(src.step[t]);
+    index.insert(index.end(), src.index.begin() + src.begin[t], src.index.begin() + src.begin[t + 1]);
+    prob.insert(prob.end(), src.prob.begin() + src.begin[t], src.prob.begin() + src.begin[t + 1]);
+    begin.push_back(static_cast<int>(index.size()));
+}
+
+void AppendLattice(const float *probs, int steps, int num_classes, int first_step, float min_prob,
+                   int max_candidates, CtcLattice &lattice) {
+    thread_local std::vector<int> selected;
+    selected.resize(std::max(1, num_classes));
+    max_candidates = std::max(1, max_candidates);
+    for (int t = 0; t < steps; t++) {
+        const float *row = probs + static_cast<size_t>(t) * num_classes;
+        // Vị trí trong selected tính từ lớp 1 (bỏ blank).
+        int count = SelectAbove(row + 1, num_classes - 1, min_prob, selected.data());
+        if (count == 0 && row[0] < min_prob && num_classes > 1) {
+            float value;
+            ArgmaxRows(row + 1, 1, num_classes - 1, selected.data(), &value);
+            count = 1;
+        }
+        if (count > max_candidates) {
+            std::partial_sort(selected.begin(), selected.begin() + max_candidates, selected.begin() + count,
+                              [row](int a, int b) { return row[a + 1] > row[b + 1]; });
+            count = max_candidates;
+        }
+        lattice.blank.push_back(row[0]);
+        lattice.step.push_back(first_step + t);
+        for (int k = 0; k < count; k++) {
+            lattice.index.push_back(selected[k] + 1);
+            lattice.prob.push_back(row[selected[k] + 1]);
+        }
+        lattice.begin.push_back(static_cast<int>(lattice.index.size()));
+    }
+}
+
+LexiconTrie::~LexiconTrie() {
+#ifndef _WIN32
+    if (mapping_)
+        munmap(mapping_, mapped_size_);
+#endif
+}
+
+std::shared_ptr<const LexiconTrie> LexiconTrie::Open(const std::string &path) {
+    std::shared_ptr<LexiconTrie> trie(new LexiconTrie());
+    const uint32_t *words = nullptr;
+    size_t size = 0;
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping != MAP_FAILED) {
+            trie->mapping_ = mapping;
+            trie->mapped_size_ = static_cast<size_t>(st.st_size);
+        }
+    }
+    close(fd);
+    if (!trie->mapping_)
+        return nullptr;
+    words = static_cast<const uint32_t *>(trie->mapping_);
+    size = trie->mapped_size_;
+#else
+    std::ifstream infile(path, std::ios::binary | std::ios::ate);
+    if (!infile)
+        return nullptr;
+    size = static_cast<size_t>(infile.tellg());
+    trie->buffer_.resize(size / sizeof(uint32_t));
+    infile.seekg(0);
+    infile.read(reinterpret_cast<char *>(trie->buffer_.data()), trie->buffer_.size() * sizeof(uint32_t));
+    if (!infile)
+        return nullptr;
+    words = trie->buffer_.data();
+#endif
+
+    // Kiểm tra header và kích thước trước khi trỏ vào các mảng.
+    const size_t total = size / sizeof(uint32_t);
+    if (total < kTrieHeaderWords || words[0] != kTrieMagic || words[1] != kTrieVersion)
+        return nullptr;
+    const uint64_t num_nodes = words[2], num_edges = words[3];
+    if (num_nodes == 0 || kTrieHeaderWords + (num_nodes + 1) + 2 * num_edges > total)
+        return nullptr;
+    trie->num_nodes_ = static_cast<uint32_t>(num_nodes);
+    trie->begin_ = words + kTrieHeaderWords;
+    trie->labels_ = trie->begin_ + num_nodes + 1;
+    trie->children_ = trie->labels_ + num_edges;
+    // Kiểm tra nội dung một lần để child() / terminal() không bao giờ đọc ra ngoài file: khoảng cạnh của
+    // mỗi node nằm trong [0, num_edges] và không giảm, mọi node con là node có thật.
+    if (num_nodes > static_cast<uint64_t>(std::numeric_limits<int>::max()))
+        return nullptr;
+    uint32_t prev = 0;
+    for (uint64_t node = 0; node <= num_nodes; node++) {
+        const uint32_t first = trie->begin_[node] & ~kTerminalBit;
+        if (first < prev || first > num_edges)
+            return nullptr;
+        prev = first;
+    }
+    for (uint64_t edge = 0; edge < num_edges; edge++) {
+        if (trie->children_[edge] >= num_nodes)
+            return nullptr;
+    }
+    return trie;
+}
+
+int LexiconTrie::Compile(const std::vector<std::string> &words, const std::vector<std::string> &char_list,
+                         const std::string &path) {
+    const CharListIndex index(char_list);
+
+    // Trie tạm trong bộ nhớ, sau đó được đánh số lại theo BFS để cạnh của mỗi node nằm liền nhau.
+    std::vector<std::map<int, int>> edges(1);
+    std::vector<bool> is_terminal(1, false);
+    std::vector<int> labels;
+    int added = 0;
+    for (const std::string &word : words) {
+        if (!index.split(word, labels))
+            continue;
+        int node = 0;
+        for (int label : labels) {
+            auto it = edges[node].find(label);
+            if (it == edges[node].end()) {
+                it = edges[node].emplace(label, static_cast<int>(edges.size())).first;
+                edges.emplace_back();
+                is_terminal.push_back(false);
+            }
+            node = it->second;
+        }
+        is_terminal[node] = true;
+        added++;
+    }
+
+    std::vector<int> order(1, 0), new_id(edges.size(), -1);
+    new_id[0] = 0;
+    for (size_t k = 0; k < order.size(); k++) {
+        for (const auto &edge : edges[order[k]]) {
+            new_id[edge.second] = static_cast<int>(order.size());
+            order.push_back(edge.second);
+        }
+    }
+    std::vector<uint32_t> out = {kTrieMagic, kTrieVersion, static_cast<uint32_t>(order.size()), 0};
+    std::vector<uint32_t> edge_labels, edge_children;
+    for (int node : order) {
+        out.push_back(static_cast<uint32_t>(edge_labels.size()) | (is_terminal[node] ? kTerminalBit : 0u));
+        for (const auto &edge : edges[node]) {
+            edge_labels.push_back(static_cast<uint32_t>(edge.first));
+            edge_children.push_back(static_cast<uint32_t>(new_id[edge.second]));
+        }
+    }
+    out.push_back(static_cast<uint32_t>(edge_labels.size()));
+    out[3] = static_cast<uint32_t>(edge_labels.size());
+    out.insert(out.end(), edge_labels.begin(), edge_labels.end());
+    out.insert(out.end(), edge_children.begin(), edge_children.end());
+
+    std::ofstream outfile(path, std::ios::binary | std::ios::trunc);
+    outfile.write(reinterpret_cast<const char *>(out.data()), out.size() * sizeof(uint32_t));
+    return outfile ? added : -1;
+}
+
+int LexiconTrie::child(int node, int label) const {
+    const uint32_t *first = labels_ + (begin_[node] & ~kTerminalBit);
+    const uint32_t *last = labels_ + (begin_[node + 1] & ~kTerminalBit);
+    const uint32_t *it = std::lower_bound(first, last, static_cast<uint32_t>(label));
+    if (it == last || *it != static_cast<uint32_t>(label))
+        return -1;
+    return static_cast<int>(children_[it - labels_]);
+}
+
+bool LexiconTrie::terminal(int node) const {
+    return (begin_[node] & kTerminalBit) != 0;
+}
+
+DecodeResult BeamSearchDecode(const CtcLattice &lattice, const std::vector<std::string> &char_list,
+                              int beam_width, const LexiconTrie *lexicon) {
+    const int dict_size = static_cast<int>(char_list.size());
+    const size_t width = static_cast<size_t>(std::max(1, beam_width));
+    // Bộ nhớ tạm dùng lại giữa các dòng (mỗi luồng một bộ).
+    thread_local std::vector<PrefixNode> nodes;
+    thread_local std::vector<Beam> beams, next;
+    nodes.assign(1, PrefixNode{-1, 0, LexiconTrie::kRoot, 0, 0, 0.f, -1, -1});
+    beams.assign(1, Beam{0, 1.f, 0.f});
+
+    // Node con của parent với ký tự label (tạo nếu chưa có), -1 nếu lexicon không cho phép.
+    auto extend = [&](int parent, int label) {
+        for (int c = nodes[parent].first_child; c >= 0; c = nodes[c].next_sibling) {
+            if (nodes[c].label == label)
+                return c;
+        }
+        int trie = 0;
+        if (lexicon) {
+            trie = lexicon->child(nodes[parent].trie, label);
+            if (trie < 0)
+                return -1;
+        }
+        const int id = static_cast<int>(nodes.size());
+        nodes.push_back(PrefixNode{parent, label, trie, -1, -1, 0.f, -1, nodes[parent].first_child});
+        nodes[parent].first_child = id;
+        return id;
+    };
+    // Ô của node trong beam bước sau (số ô nhỏ nên tìm tuyến tính).
+    auto slot = [&](int node) -> Beam & {
+        for (Beam &b : next) {
+            if (b.node == node)
+                return b;
+        }
+        next.push_back(Beam{node, 0.f, 0.f});
+        return next.back();
+    };
+
+    for (size_t t = 0; t < lattice.size(); t++) {
+        const float blank = lattice.blank[t];
+        const int step = lattice.step[t];
+        next.clear();
+        for (const Beam &beam : beams) {
+            const int last = nodes[beam.node].label;
+            slot(beam.node).pb += beam.total() * blank;
+            for (int k = lattice.begin[t]; k < lattice.begin[t + 1]; k++) {
+                const int c = lattice.index[k];
+                const float p = lattice.prob[k];
+                if (c >= dict_size)
+                    continue;
+                float gain;
+                if (c == last) {
+                    // Lặp ký tự cuối không sinh ký tự mới; ký tự mới giống ký tự cuối cần blank xen giữa.
+                    slot(beam.node).pnb += beam.pnb * p;
+                    nodes[beam.node].end_step = std::max(nodes[beam.node].end_step, step + 1);
+                    gain = beam.pb * p;
+                } else {
+                    gain = beam.total() * p;
+                }
+                const int child = extend(beam.node, c);
+                if (child < 0 || gain <= 0.f)
+                    continue;
+                slot(child).pnb += gain;
+                PrefixNode &node = nodes[child];
+                if (p > node.prob) {
+                    node.prob = p;
+                    node.start_step = step;
+                    node.end_step = std::max(node.end_step, step + 1);
+                }
+            }
+        }
+        if (next.size() > width) {
+            std::nth_element(next.begin(), next.begin() + (width - 1), next.end(),
+                             [](const Beam &a, const Beam &b) { return a.total() > b.total(); });
+            next.resize(width);
+        }
+        // Chuẩn hóa để xác suất không bị underflow trên dòng dài (thứ hạng không đổi).
+        float best = 0.f;
+        for (const Beam &b : next)
+            best = std::max(best, b.total());
+        if (best > 0.f) {
+            for (Beam &b : next) {
+                b.pb /= best;
+                b.pnb /= best;
+            }
+        }
+        beams.swap(next);
+    }
+
+    const Beam *best = nullptr;
+    for (int pass = 0; pass < 2 && !best; pass++) {
+        for (const Beam &b : beams) {
+            if (pass == 0 && lexicon && !lexicon->terminal(nodes[b.node].trie))
+                continue;
+            if (!best || b.total() > best->total())
+                best = &b;
+        }
+    }
+
+    DecodeResult result;
+    result.confidence = 0.f;
+    std::vector<int> path;
+    for (int n = best ? best->node : 0; n > 0; n = nodes[n].parent)
+        path.push_back(n);
+    result.chars.reserve(path.size());
+    float confidence_sum = 0.f;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        const PrefixNode &node = nodes[*it];
+        result.text += char_list[node.label];
+        result.chars.push_back(CharInfo{node.start_step, std::max(node.end_step, node.start_step + 1), node.prob});
+        confidence_sum += node.prob;
+    }
+    result.confidence = path.empty() ? 0.f : confidence_sum / path.size();
+    return result;
+}
+
+} // namespace ocr
@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ocr {
+
+// Một ký tự đã decode: khoảng bước thời gian [start_step, end_step) của output sinh ra nó
+// và xác suất ở bước đầu tiên.
+struct CharInfo {
+    int start_step;
+    int end_step;
+    float prob;
+};
+
+struct DecodeResult {
+    std::string text;
+    float confidence;
+    // Từng ký tự của text theo thứ tự (cùng số phần tử với số ký tự trong từ điển đã ghép vào text).
+    std::vector<CharInfo> chars;
+    // Số cột input (tại chiều cao 48) ứng với một bước thời gian, và chiều rộng input của cả dòng:
+    // ký tự nằm trong khoảng [start_step, end_step) * step_width / input_width của chiều rộng box.
+    float step_width = 0.f;
+    int input_width = 0;
+};
+
+// Đường argmax CTC: lớp có xác suất lớn nhất, xác suất đó và chỉ số bước thời gian (trên cả dòng) ở mỗi bước.
+struct CtcPath {
+    std::vector<int> index;
+    std::vector<float> prob;
+    std::vector<int> step;
+
+    size_t size() const { return index.size(); }
+    // Bước t là blank.
+    bool isBlank(size_t t) const { return index[t] == 0; }
+    // Nối bước t của src vào cuối.
+    void appendStep(const CtcPath &src, size_t t);
+};
+
+// Nối đường argmax của steps bước thời gian (mỗi bước num_classes xác suất, đọc thẳng từ output tensor)
+// vào path; bước đầu tiên có chỉ số first_step.
+void AppendArgmax(const float *probs, int steps, int num_classes, int first_step, CtcPath &path);
+
+// Gộp CTC (greedy): bỏ blank (lớp 0) và các lớp lặp liên tiếp, confidence là trung bình xác suất ký tự.
+// Mỗi ký tự kèm khoảng bước thời gian của chuỗi lặp sinh ra nó và xác suất ở bước đầu tiên.
+DecodeResult CollapsePath(const CtcPath &path, const std::vector<std::string> &char_list);
+
+// Lưới CTC thưa cho beam search: mỗi bước giữ xác suất blank và các lớp khác blank đáng kể
+// (index / prob trong khoảng [begin[t], begin[t + 1])), các lớp còn lại coi như xác suất 0.
+struct CtcLattice {
+    std::vector<float> blank;
+    std::vector<int> step;
+    std::vector<int> begin;
+    std::vector<int> index;
+    std::vector<float> prob;
+
+    CtcLattice() : begin(1, 0) {}
+    size_t size() const { return blank.size(); }
+    // Blank là lớp có xác suất lớn nhất ở bước t.
+    bool isBlank(size_t t) const;
+    // Nối bước t của src vào cuối.
+    void appendStep(const CtcLattice &src, size_t t);
+};
+
+// Nối steps bước thời gian vào lattice, mỗi bước giữ tối đa max_candidates lớp khác blank có xác suất
+// >= min_prob (lớn nhất trước). Bước mà blank và mọi lớp đều dưới ngưỡng vẫn giữ lớp lớn nhất.
+void AppendLattice(const float *probs, int steps, int num_classes, int first_step, float min_prob,
+                   int max_candidates, CtcLattice &lattice);
+
+// Tách chuỗi UTF-8 thành các lớp của từ điển ký tự (bỏ lớp 0 là blank) theo khớp dài nhất.
+class CharListIndex {
+public:
+    explicit CharListIndex(const std::vector<std::string> &char_list);
+    // false nếu text rỗng hoặc có ký tự ngoài từ điển.
+    bool split(const std::string &text, std::vector<int> &labels) const;
+
+private:
+    std::unordered_map<std::string, int> classes_;
+    size_t max_len_ = 1;
+};
+
+// Trie từ vựng gọn trong một file nhị phân, được map thẳng vào bộ nhớ (mmap, chỉ đọc): mở file không
+// phải dựng lại cấu trúc nào nên từ điển lớn load tức thì, và các tiến trình cùng map một file dùng chung
+// page cache. Nhãn cạnh là chỉ số lớp trong từ điển ký tự của mô hình, nên file chỉ dùng được với đúng
+// từ điển đã biên dịch nó. Layout (uint32, byte order của máy biên dịch): magic, version, số node,
+// số cạnh, begin[số node + 1] (bit cao: node kết thúc một từ), label[số cạnh], child[số cạnh];
+// cạnh của mỗi node liền nhau và tăng dần theo nhãn.
+class LexiconTrie {
+public:
+    ~LexiconTrie();
+    LexiconTrie(const LexiconTrie &) = delete;
+    LexiconTrie &operator=(const LexiconTrie &) = delete;
+
+    // Map file trie, nullptr nếu không mở được hoặc file không hợp lệ.
+    static std::shared_ptr<const LexiconTrie> Open(const std::string &path);
+
+    // Biên dịch words thành file trie: mỗi từ (UTF-8) được tách thành các ký tự của char_list theo khớp
+    // dài nhất; từ rỗng hoặc có ký tự ngoài từ điển bị bỏ qua. Trả về số từ đã đưa vào trie, -1 nếu lỗi ghi file.
+    static int Compile(const std::vector<std::string> &words, const std::vector<std::string> &char_list,
+                       const std::string &path);
+
+    static constexpr int kRoot = 0;
+    // Node con theo nhãn label, -1 nếu không có.
+    int child(int node, int label) const;
+    // Node có kết thúc một từ không.
+    bool terminal(int node) const;
+    int nodeCount() const { return static_cast<int>(num_nodes_); }
+
+private:
+    LexiconTrie() = default;
+
+    void *mapping_ = nullptr;
+    size_t mapped_size_ = 0;
+    // Bản đọc vào bộ nhớ khi không có mmap.
+    std::vector<uint32_t> buffer_;
+    uint32_t num_nodes_ = 0;
+    const uint32_t *begin_ = nullptr;
+    const uint32_t *labels_ = nullptr;
+    const uint32_t *children_ = nullptr;
+};
+
+// Prefix beam search trên lattice: giữ beam_width tiền tố tốt nhất (gộp xác suất mọi đường CTC cho cùng
+// một tiền tố) ở mỗi bước. Với lexicon, chỉ mở rộng tiền tố còn nằm trong trie và ưu tiên tiền tố kết thúc
+// một từ ở bước cuối (nếu không có, trả về tiền tố tốt nhất). confidence là trung bình xác suất ký tự;
+// khoảng bước của mỗi ký tự là gần đúng (bước có xác suất lớn nhất khi sinh ký tự đến lần lặp cuối).
+DecodeResult BeamSearchDecode(const CtcLattice &lattice, const std::vector<std::string> &char_list,
+                              int beam_width, const LexiconTrie *lexicon = nullptr);
+
+} // namespace ocr
@@ -0,0 +1,703 @@
+#include "ctc_pattern.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace ocr {
+
+namespace {
+
+// Giới hạn kích thước để mẫu lặp lớn không làm nổ bộ nhớ / thời gian biên dịch.
+const int kMaxRepeat = 1000;
+const int kMaxNfaStates = 20000;
+const int kMaxDfaStates = 10000;
+// Ô có log xác suất kém ô tốt nhất của cùng trạng thái DFA quá khoảng này bị bỏ (không thể vượt lên trên
+// dòng thực tế).
+const float kPruneLogGap = 30.f;
+// Số lớp giữ lại cho mỗi nhóm tương đương ở mỗi bước của lattice.
+const int kGroupCandidates = 3;
+
+// Giải mã một code point UTF-8 tại pos, trả về -1 nếu byte không hợp lệ; len nhận số byte.
+int DecodeUtf8(const std::string &s, size_t pos, size_t &len) {
+    const unsigned char c = static_cast<unsigned char>(s[pos]);
+    int cp, extra;
+    if (c < 0x80) {
+        cp = c;
+        extra = 0;
+    } else if ((c & 0xe0) == 0xc0) {
+        cp = c & 0x1f;
+        extra = 1;
+    } else if ((c & 0xf0) == 0xe0) {
+        cp = c & 0x0f;
+        extra = 2;
+    } else if ((c & 0xf8) == 0xf0) {
+        cp = c & 0x07;
+        extra = 3;
+    } else {
+        len = 1;
+        return -1;
+    }
+    if (extra > 0 && pos + extra >= s.size()) {
+        len = 1;
+        return -1;
+    }
+    for (int k = 1; k <= extra; k++) {
+        const unsigned char b = static_cast<unsigned char>(s[pos + k]);
+        if ((b & 0xc0) != 0x80) {
+            len = 1;
+            return -1;
+        }
+        cp = (cp << 6) | (b & 0x3f);
+    }
+    len = extra + 1;
+    return cp;
+}
+
+// Tập ký tự của một nguyên tử trong mẫu: các khoảng code point, có thể phủ định.
+struct CharSet {
+    std::vector<std::pair<int, int>> ranges;
+    bool negated = false;
+};
+
+// Cây cú pháp của mẫu.
+struct RegexNode {
+    enum Kind { kSet, kConcat, kAlt, kRepeat } kind;
+    int set = -1;
+    std::vector<int> children;
+    int min = 0;
+    int max = 0;  // -1: không giới hạn
+};
+
+// Phân tích cú pháp đệ quy xuống: alt := concat ('|' concat)*, concat := repeat*, repeat := atom quant*.
+class RegexParser {
+public:
+    explicit RegexParser(const std::string &pattern) : pattern_(pattern) {}
+
+    bool parse(int &root) {
+        root = parseAlt();
+        if (error_.empty() && pos_ < pattern_.size())
+            fail("dấu ')' thừa");
+        return error_.empty();
+    }
+
+    std::vector<RegexNode> nodes;
+    std::vector<CharSet> sets;
+    const std::string &error() const { return error_; }
+
+private:
+    int addNode(RegexNode node) {
+        nodes.push_back(std::move(node));
+        return static_cast<int>(nodes.size()) - 1;
+    }
+    int addSet(CharSet set) {
+        sets.push_back(std::move(set));
+        RegexNode node{RegexNode::kSet, static_cast<int>(sets.size()) - 1, {}, 0, 0};
+        return addNode(node);
+    }
+    void fail(const std::string &message) {
+        if (error_.empty())
+            error_ = message + " (vị trí " + std::to_string(pos_) + ")";
+    }
+    bool done() const { return pos_ >= pattern_.size() || !error_.empty(); }
+
+    int parseAlt() {
+        RegexNode alt{RegexNode::kAlt, -1, {}, 0, 0};
+        alt.children.push_back(parseConcat());
+        while (!done() && pattern_[pos_] == '|') {
+            pos_++;
+            alt.children.push_back(parseConcat());
+        }
+        return alt.children.size() == 1 ? alt.children.front() : addNode(alt);
+    }
+
+    int parseConcat() {
+        RegexNode concat{RegexNode::kConcat, -1, {}, 0, 0};
+        while (!done() && pattern_[pos_] != '|' && pattern_[pos_] != ')') {
+            int atom = parseAtom();
+            if (atom < 0)
+                continue;
+            concat.children.push_back(parseQuantifiers(atom));
+        }
+        return addNode(concat);
+    }
+
+    int parseQuantifiers(int atom) {
+        while (!done()) {
+            int min, max;
+            const char c = pattern_[pos_];
+            if (c == '*') {
+                min = 0;
+                max = -1;
+                pos_++;
+            } else if (c == '+') {
+                min = 1;
+                max = -1;
+                pos_++;
+            } else if (c == '?') {
+                min = 0;
+                max = 1;
+                pos_++;
+            } else if (c == '{') {
+                pos_++;
+                if (!parseNumber(min))
+                    return atom;
+                max = min;
+                if (!done() && pattern_[pos_] == ',') {
+                    pos_++;
+                    max = -1;
+                    if (!done() && pattern_[pos_] != '}' && !parseNumber(max))
+                        return atom;
+                }
+                if (done() || pattern_[pos_] != '}') {
+                    fail("thiếu '}'");
+                    return atom;
+                }
+                pos_++;
+                if (min > kMaxRepeat || max > kMaxRepeat || (max >= 0 && max < min)) {
+                    fail("số lần lặp không hợp lệ");
+                    return atom;
+                }
+            } else {
+                break;
+            }
+            RegexNode repeat{RegexNode::kRepeat, -1, {atom}, min, max};
+            atom = addNode(repeat);
+        }
+        return atom;
+    }
+
+    bool parseNumber(int &value) {
+        size_t start = pos_;
+        value = 0;
+        while (pos_ < pattern_.size() && pattern_[pos_] >= '0' && pattern_[pos_] <= '9' && value <= kMaxRepeat)
+            value = value * 10 + (pattern_[pos_++] - '0');
+        if (pos_ == start)
+            fail("thiếu số lần lặp");
+        return pos_ != start;
+    }
+
+    // Đọc một code point (đã xử lý escape ký tự thường); false nếu lỗi.
+    bool readChar(int &cp) {
+        size_t len;
+        cp = DecodeUtf8(pattern_, pos_, len);
+        pos_ += len;
+        if (cp < 0)
+            fail("UTF-8 không hợp lệ");
+        return cp >= 0;
+    }
+
+    // Escape lớp ký tự \d \w \s (không phủ định) vào set; false nếu c không phải escape lớp.
+    static bool AddEscapeClass(char c, CharSet &set) {
+        switch (c) {
+        case 'd':
+            set.ranges.push_back({'0', '9'});
+            return true;
+        case 'w':
+            set.ranges.push_back({'0', '9'});
+            set.ranges.push_back({'A', 'Z'});
+            set.ranges.push_back({'a', 'z'});
+            set.ranges.push_back({'_', '_'});
+            return true;
+        case 's':
+            set.ranges.push_back({' ', ' '});
+            set.ranges.push_back({'\t', '\r'});
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    int parseAtom() {
+        const char c = pattern_[pos_];
+        if (c == '(') {
+            pos_++;
+            if (pattern_.compare(pos_, 2, "?:") == 0)
+                pos_ += 2;
+            int inner = parseAlt();
+            if (done() || pattern_[pos_] != ')') {
+                fail("thiếu ')'");
+                return inner;
+            }
+            pos_++;
+            return inner;
+        }
+        if (c == '^' || c == '$') {
+            pos_++;
+            return -1;
+        }
+        if (c == '*' || c == '+' || c == '?' || c == '{') {
+            fail("lượng từ không có gì đứng trước");
+            return -1;
+        }
+        if (c == '.') {
+            pos_++;
+            CharSet set;
+            set.negated = true;
+            return addSet(set);
+        }
+        if (c == '[')
+            return parseClass();
+        CharSet set;
+        int cp;
+        if (c == '\\') {
+            pos_++;
+            if (done()) {
+                fail("'\\' ở cuối mẫu");
+                return -1;
+            }
+            // \D \W \S là phủ định của \d \w \s; escape khác là ký tự thường.
+            const char e = pattern_[pos_];
+            const char lower = static_cast<char>(std::tolower(static_cast<unsigned char>(e)));
+            if (AddEscapeClass(lower, set)) {
+                set.negated = e != lower;
+                pos_++;
+                return addSet(set);
+            }
+        }
+        if (!readChar(cp))
+            return -1;
+        set.ranges.push_back({cp, cp});
+        return addSet(set);
+    }
+
+    int parseClass() {
+        pos_++;  // '['
+        CharSet set;
+        if (!done() && pattern_[pos_] == '^') {
+            set.negated = true;
+            pos_++;
+        }
+        bool first = true;
+        while (!done() && (pattern_[pos_] != ']' || first)) {
+            first = false;
+            int lo;
+            if (pattern_[pos_] == '\\') {
+                pos_++;
+                if (done())
+                    break;
+                if (AddEscapeClass(pattern_[pos_], set)) {
+                    pos_++;
+                    continue;
+                }
+            }
+            if (!readChar(lo))
+                return -1;
+            int hi = lo;
+            if (pos_ + 1 < pattern_.size() && pattern_[pos_] == '-' && pattern_[pos_ + 1] != ']') {
+                pos_++;
+                if (pattern_[pos_] == '\\')
+                    pos_++;
+                if (done() || !readChar(hi))
+                    return -1;
+                if (hi < lo) {
+                    fail("khoảng ký tự ngược");
+                    return -1;
+                }
+            }
+            set.ranges.push_back({lo, hi});
+        }
+        if (done()) {
+            fail("thiếu ']'");
+            return -1;
+        }
+        pos_++;  // ']'
+        return addSet(set);
+    }
+
+    const std::string &pattern_;
+    size_t pos_ = 0;
+    std::string error_;
+};
+
+// NFA Thompson: mỗi trạng thái có các cạnh epsilon và tối đa một cạnh theo tập ký tự.
+struct NfaState {
+    std::vector<int> eps;
+    int set = -1;
+    int next = -1;
+};
+
+class NfaBuilder {
+public:
+    explicit NfaBuilder(const std::vector<RegexNode> &nodes) : nodes_(nodes) {}
+
+    // Dựng đoạn NFA của node, trả về (đầu, cuối); false nếu vượt kMaxNfaStates.
+    bool build(int node, int &start, int &end) {
+        const RegexNode &n = nodes_[node];
+        switch (n.kind) {
+        case RegexNode::kSet:
+            start = add();
+            end = add();
+            states[start].set = n.set;
+            states[start].next = end;
+            break;
+        case RegexNode::kConcat:
+            start = end = add();
+            for (int child : n.children) {
+                int s, e;
+                if (!build(child, s, e))
+                    return false;
+                states[end].eps.push_back(s);
+                end = e;
+            }
+            break;
+        case RegexNode::kAlt:
+            start = add();
+            end = add();
+            for (int child : n.children) {
+                int s, e;
+                if (!build(child, s, e))
+                    return false;
+                states[start].eps.push_back(s);
+                states[e].eps.push_back(end);
+            }
+            break;
+        case RegexNode::kRepeat: {
+            start = end = add();
+            // min bản bắt buộc, sau đó một vòng lặp (max = -1) hoặc max - min bản tùy chọn.
+            for (int i = 0; i < n.min; i++) {
+                int s, e;
+                if (!build(n.children[0], s, e))
+                    return false;
+                states[end].eps.push_back(s);
+                end = e;
+            }
+            if (n.max < 0) {
+                int s, e;
+                if (!build(n.children[0], s, e))
+                    return false;
+                const int hub = add();
+                states[end].eps.push_back(hub);
+                states[hub].eps.push_back(s);
+                states[e].eps.push_back(hub);
+                end = hub;
+            } else if (n.max > n.min) {
+                const int exit = add();
+                for (int i = n.min; i < n.max; i++) {
+                    int s, e;
+                    if (!build(n.children[0], s, e))
+                        return false;
+                    states[end].eps.push_back(exit);
+                    states[end].eps.push_back(s);
+                    end = e;
+                }
+                states[end].eps.push_back(exit);
+                end = exit;
+            }
+            break;
+        }
+        }
+        return static_cast<int>(states.size()) <= kMaxNfaStates;
+    }
+
+    std::vector<NfaState> states;
+
+private:
+    int add() {
+        states.emplace_back();
+        return static_cast<int>(states.size()) - 1;
+    }
+
+    const std::vector<RegexNode> &nodes_;
+};
+
+// Bao đóng epsilon của tập trạng thái (kết quả sắp tăng dần, không trùng).
+void EpsilonClosure(const std::vector<NfaState> &nfa, std::vector<int> &set, std::vector<char> &mark) {
+    std::vector<int> stack(set);
+    for (int s : set)
+        mark[s] = 1;
+    while (!stack.empty()) {
+        int s = stack.back();
+        stack.pop_back();
+        for (int t : nfa[s].eps) {
+            if (!mark[t]) {
+                mark[t] = 1;
+                set.push_back(t);
+                stack.push_back(t);
+            }
+        }
+    }
+    for (int s : set)
+        mark[s] = 0;
+    std::sort(set.begin(), set.end());
+}
+
+} // namespace
+
+std::shared_ptr<const PatternDfa> PatternDfa::Compile(const std::string &pattern,
+                                                      const std::vector<std::string> &char_list,
+                                                      std::string *error) {
+    RegexParser parser(pattern);
+    int root;
+    if (!parser.parse(root)) {
+        if (error)
+            *error = parser.error();
+        return nullptr;
+    }
+    NfaBuilder builder(parser.nodes);
+    int nfa_start, nfa_end;
+    if (!builder.build(root, nfa_start, nfa_end)) {
+        if (error)
+            *error = "mẫu quá lớn";
+        return nullptr;
+    }
+    const std::vector<NfaState> &nfa = builder.states;
+
+    // Thành viên của mỗi tập ký tự theo lớp từ điển (lớp 0 là blank, không bao giờ khớp).
+    const int dict_size = static_cast<int>(char_list.size());
+    std::vector<int> label_cp(dict_size, -1);
+    for (int i = 1; i < dict_size; i++) {
+        size_t len;
+        if (!char_list[i].empty()) {
+            int cp = DecodeUtf8(char_list[i], 0, len);
+            if (len == char_list[i].size())
+                label_cp[i] = cp;
+        }
+    }
+    const size_t num_sets = parser.sets.size();
+    std::vector<std::vector<bool>> member(num_sets, std::vector<bool>(dict_size, false));
+    for (size_t k = 0; k < num_sets; k++) {
+        const CharSet &set = parser.sets[k];
+        for (int i = 1; i < dict_size; i++) {
+            bool in = false;
+            for (const auto &range : set.ranges)
+                in = in || (label_cp[i] >= range.first && label_cp[i] <= range.second);
+            member[k][i] = in != set.negated;
+        }
+    }
+
+    // Lớp tương đương: các lớp từ điển thuộc cùng những tập ký tự.
+    std::shared_ptr<PatternDfa> dfa(new PatternDfa());
+    dfa->label_group_.assign(dict_size, -1);
+    std::map<std::vector<bool>, int> signatures;
+    std::vector<int> representative;
+    std::vector<bool> signature(num_sets);
+    for (int i = 1; i < dict_size; i++) {
+        bool any = false;
+        for (size_t k = 0; k < num_sets; k++) {
+            signature[k] = member[k][i];
+            any = any || signature[k];
+        }
+        if (!any)
+            continue;
+        auto it = signatures.emplace(signature, static_cast<int>(representative.size())).first;
+        if (it->second == static_cast<int>(representative.size()))
+            representative.push_back(i);
+        dfa->label_group_[i] = it->second;
+        dfa->allowed_labels_.push_back(i);
+    }
+    dfa->num_groups_ = static_cast<int>(representative.size());
+
+    // Dựng DFA bằng xây dựng tập con, trạng thái 0 là bao đóng của trạng thái đầu NFA.
+    std::vector<char> mark(nfa.size(), 0);
+    std::map<std::vector<int>, int> ids;
+    std::vector<std::vector<int>> subsets(1, std::vector<int>(1, nfa_start));
+    EpsilonClosure(nfa, subsets[0], mark);
+    ids.emplace(subsets[0], 0);
+    for (size_t q = 0; q < subsets.size(); q++) {
+        dfa->accepting_.push_back(std::binary_search(subsets[q].begin(), subsets[q].end(), nfa_end) ? 1 : 0);
+        for (int g = 0; g < dfa->num_groups_; g++) {
+            std::vector<int> target;
+            for (int s : subsets[q]) {
+                if (nfa[s].set >= 0 && member[nfa[s].set][representative[g]] && !mark[nfa[s].next]) {
+                    mark[nfa[s].next] = 1;
+                    target.push_back(nfa[s].next);
+                }
+            }
+            for (int s : target)
+                mark[s] = 0;
+            int id = -1;
+            if (!target.empty()) {
+                EpsilonClosure(nfa, target, mark);
+                auto it = ids.emplace(target, static_cast<int>(subsets.size())).first;
+                if (it->second == static_cast<int>(subsets.size())) {
+                    if (static_cast<int>(subsets.size()) >= kMaxDfaStates) {
+                        if (error)
+                            *error = "DFA quá lớn";
+                        return nullptr;
+                    }
+                    subsets.push_back(target);
+                }
+                id = it->second;
+            }
+            dfa->next_.push_back(id);
+        }
+    }
+    return dfa;
+}
+
+int PatternDfa::next(int state, int label) const {
+    if (label < 0 || label >= static_cast<int>(label_group_.size()) || label_group_[label] < 0)
+        return -1;
+    return next_[static_cast<size_t>(state) * num_groups_ + label_group_[label]];
+}
+
+bool PatternDfa::matches(const std::vector<int> &labels) const {
+    int state = start();
+    for (int label : labels) {
+        state = next(state, label);
+        if (state < 0)
+            return false;
+    }
+    return accepting(state);
+}
+
+void PatternDfa::appendLattice(const float *probs, int steps, int num_classes, int first_step,
+                               CtcLattice &lattice) const {
+    // Mỗi nhóm giữ kGroupCandidates lớp lớn nhất, giảm dần (label -1: ô trống).
+    thread_local std::vector<int> best_label;
+    thread_local std::vector<float> best_prob;
+    for (int t = 0; t < steps; t++) {
+        const float *row = probs + static_cast<size_t>(t) * num_classes;
+        best_label.assign(static_cast<size_t>(num_groups_) * kGroupCandidates, -1);
+        best_prob.assign(best_label.size(), -1.f);
+        for (int label : allowed_labels_) {
+            if (label >= num_classes)
+                break;
+            const float p = row[label];
+            float *group_prob = best_prob.data() + label_group_[label] * kGroupCandidates;
+            if (p <= group_prob[kGroupCandidates - 1])
+                continue;
+            int *group_label = best_label.data() + label_group_[label] * kGroupCandidates;
+            int k = kGroupCandidates - 1;
+            for (; k > 0 && p > group_prob[k - 1]; k--) {
+                group_prob[k] = group_prob[k - 1];
+                group_label[k] = group_label[k - 1];
+            }
+            group_prob[k] = p;
+            group_label[k] = label;
+        }
+        lattice.blank.push_back(row[0]);
+        lattice.step.push_back(first_step + t);
+        for (size_t k = 0; k < best_label.size(); k++) {
+            if (best_label[k] >= 0) {
+                lattice.index.push_back(best_label[k]);
+                lattice.prob.push_back(best_prob[k]);
+            }
+        }
+        lattice.begin.push_back(static_cast<int>(lattice.index.size()));
+    }
+}
+
+DecodeResult PatternDecode(const CtcLattice &lattice, const std::vector<std::string> &char_list,
+                           const PatternDfa &dfa) {
+    const float kDead = -std::numeric_limits<float>::infinity();
+    const int states = dfa.stateCount();
+    const int steps = static_cast<int>(lattice.size());
+    // Ô của bước t: trạng thái q x (blank + các ứng viên của bước), ô = q * stride + slot (slot 0 là blank).
+    // back giữ ô của bước trước dẫn tới mỗi ô (đánh số theo layout bước trước).
+    thread_local std::vector<float> score, prev_score, log_prob;
+    thread_local std::vector<int> back;
+    thread_local std::vector<size_t> offsets;
+    prev_score.assign(states, kDead);
+    prev_score[dfa.start()] = 0.f;
+    int prev_stride = 1, prev_begin = 0;
+    back.clear();
+    offsets.clear();
+
+    for (int t = 0; t < steps; t++) {
+        const int begin = lattice.begin[t], count = lattice.begin[t + 1] - begin;
+        const int stride = 1 + count;
+        score.assign(static_cast<size_t>(states) * stride, kDead);
+        offsets.push_back(back.size());
+        back.resize(back.size() + score.size(), -1);
+        int *from = back.data() + offsets.back();
+        const float log_blank = std::log(std::max(lattice.blank[t], 1e-30f));
+        log_prob.resize(count);
+        for (int k = 0; k < count; k++)
+            log_prob[k] = std::log(std::max(lattice.prob[begin + k], 1e-30f));
+        auto relax = [&](int cell, float value, int source) {
+            if (value > score[cell]) {
+                score[cell] = value;
+                from[cell] = source;
+            }
+        };
+
+        for (int q = 0; q < states; q++) {
+            // Chỉ so với các ô cùng trạng thái: ô của trạng thái khác có thể là đường duy nhất tới trạng thái
+            // chấp nhận, nên không bị cắt theo ô tốt nhất của cả bước.
+            const float *state_score = prev_score.data() + q * prev_stride;
+            const float floor = *std::max_element(state_score, state_score + prev_stride) - kPruneLogGap;
+            for (int s = 0; s < prev_stride; s++) {
+                const int cell = q * prev_stride + s;
+                const float value = prev_score[cell];
+                if (value == kDead || value < floor)
+                    continue;
+                const int prev_label = s == 0 ? -1 : lattice.index[prev_begin + s - 1];
+                relax(q * stride, value + log_blank, cell);
+                for (int k = 0; k < count; k++) {
+                    const int label = lattice.index[begin + k];
+                    if (label == prev_label) {
+                        // Lặp lớp của bước trước: cùng ký tự, không đổi trạng thái.
+                        relax(q * stride + 1 + k, value + log_prob[k], cell);
+                    } else {
+                        const int next = dfa.next(q, label);
+                        if (next >= 0)
+                            relax(next * stride + 1 + k, value + log_prob[k], cell);
+                    }
+                }
+            }
+        }
+        prev_score.swap(score);
+        prev_stride = stride;
+        prev_begin = begin;
+    }
+
+    DecodeResult result;
+    result.confidence = 0.f;
+    int best = -1;
+    for (int q = 0; q < states; q++) {
+        if (!dfa.accepting(q))
+            continue;
+        for (int s = 0; s < prev_stride; s++) {
+            const int cell = q * prev_stride + s;
+            if (prev_score[cell] != kDead && (best < 0 || prev_score[cell] > prev_score[best]))
+                best = cell;
+        }
+    }
+    if (best < 0 || steps == 0)
+        return result;
+
+    // Lần ngược: mỗi bước có slot > 0 là một lớp; lớp khác lớp của bước trước là ký tự mới.
+    std::vector<std::pair<int, int>> path(steps);  // (slot, chỉ số ứng viên trong lattice) theo bước
+    for (int t = steps - 1, cell = best; t >= 0; t--) {
+        const int stride = 1 + lattice.begin[t + 1] - lattice.begin[t];
+        const int slot = cell % stride;
+        path[t] = std::make_pair(slot, slot > 0 ? lattice.begin[t] + slot - 1 : -1);
+        cell = back[offsets[t] + cell];
+    }
+    float confidence_sum = 0.f;
+    int prev_label = -1;
+    for (int t = 0; t < steps; t++) {
+        const int k = path[t].second;
+        const int label = k >= 0 ? lattice.index[k] : -1;
+        if (label >= 0 && label != prev_label) {
+            result.text += char_list[label];
+            result.chars.push_back(CharInfo{lattice.step[t], lattice.step[t] + 1, lattice.prob[k]});
+            confidence_sum += lattice.prob[k];
+        } else if (label >= 0) {
+            result.chars.back().end_step = lattice.step[t] + 1;
+        }
+        prev_label = label;
+    }
+    result.confidence = result.chars.empty() ? 0.f : confidence_sum / result.chars.size();
+    return result;
+}
+
+std::shared_ptr<const PatternDfa> PatternDfaCache::get(const std::string &pattern,
+                                                       const std::vector<std::string> &char_list,
+                                                       std::string *error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(pattern);
+    if (it == entries_.end()) {
+        Entry entry;
+        entry.dfa = PatternDfa::Compile(pattern, char_list, &entry.error);
+        it = entries_.emplace(pattern, std::move(entry)).first;
+    }
+    if (error)
+        *error = it->second.error;
+    return it->second.dfa;
+}
+
+} // namespace ocr
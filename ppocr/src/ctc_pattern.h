@@ -0,0 +1,74 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ctc_decoder.h"
+
+namespace ocr {
+
+// DFA của một mẫu định dạng (ngày tháng, IBAN, số serial, biển số...) trên bảng chữ là các lớp của từ điển
+// ký tự: chuỗi lớp được chấp nhận khi text ghép từ chúng khớp toàn bộ mẫu. Cú pháp: ký tự thường,
+// '.', lớp [a-z0-9] / [^...], \d \w \s (và \D \W \S ngoài lớp), ký tự escape \., nhóm (...) / (?:...),
+// '|', các lượng từ * + ? {m} {m,} {m,n}; ^ và $ được bỏ qua (mẫu luôn khớp cả dòng). Mỗi ký tự
+// của mẫu chỉ khớp phần tử từ điển là đúng một ký tự đó; phần tử nhiều ký tự chỉ khớp '.' và lớp phủ định.
+// Các lớp có cùng tập chuyển trạng thái được gộp thành một lớp tương đương nên bảng chuyển nhỏ.
+class PatternDfa {
+public:
+    // Biên dịch mẫu, nullptr (kèm thông báo trong error nếu có) khi mẫu sai cú pháp hoặc quá lớn.
+    static std::shared_ptr<const PatternDfa> Compile(const std::string &pattern,
+                                                     const std::vector<std::string> &char_list,
+                                                     std::string *error = nullptr);
+
+    int start() const { return 0; }
+    // Trạng thái sau khi đọc lớp label từ trạng thái state, -1 nếu mẫu không cho phép.
+    int next(int state, int label) const;
+    bool accepting(int state) const { return accepting_[state] != 0; }
+    int stateCount() const { return static_cast<int>(accepting_.size()); }
+    // Chuỗi lớp labels có khớp toàn bộ mẫu không.
+    bool matches(const std::vector<int> &labels) const;
+
+    // Nối steps bước output vào lattice cho PatternDecode: mỗi bước giữ, cho mỗi lớp tương đương mà mẫu
+    // dùng tới, vài lớp có xác suất lớn nhất trong đó (các lớp cùng nhóm dẫn tới cùng trạng thái nên lớp
+    // nhỏ hơn chỉ có ích khi kéo dài một ký tự qua nhiều bước), không lọc theo ngưỡng để luôn còn đường
+    // khớp mẫu.
+    void appendLattice(const float *probs, int steps, int num_classes, int first_step, CtcLattice &lattice) const;
+
+private:
+    PatternDfa() = default;
+
+    int num_groups_ = 0;
+    // Lớp tương đương của mỗi lớp từ điển, -1 nếu mẫu không dùng lớp đó.
+    std::vector<int> label_group_;
+    // Các lớp từ điển có lớp tương đương (tăng dần).
+    std::vector<int> allowed_labels_;
+    // Bảng chuyển stateCount() x num_groups_.
+    std::vector<int> next_;
+    std::vector<char> accepting_;
+};
+
+// Decode ràng buộc bởi mẫu: quy hoạch động (Viterbi, log xác suất) trên cặp (trạng thái DFA, lớp ở bước
+// trước hoặc blank) qua lattice của PatternDfa::appendLattice, giữ đúng quy tắc gộp CTC (lớp lặp liên tiếp
+// là một ký tự, hai ký tự giống nhau cần blank xen giữa). Trả về chuỗi của đường tốt nhất kết thúc ở trạng
+// thái chấp nhận, hoặc text "" với confidence 0 nếu không có đường nào khớp mẫu.
+DecodeResult PatternDecode(const CtcLattice &lattice, const std::vector<std::string> &char_list,
+                           const PatternDfa &dfa);
+
+// Cache DFA theo mẫu (cả mẫu lỗi, để không biên dịch lại), dùng chung giữa các recognizer cùng từ điển;
+// an toàn khi gọi từ nhiều luồng.
+class PatternDfaCache {
+public:
+    std::shared_ptr<const PatternDfa> get(const std::string &pattern, const std::vector<std::string> &char_list,
+                                          std::string *error = nullptr);
+
+private:
+    struct Entry {
+        std::shared_ptr<const PatternDfa> dfa;
+        std::string error;
+    };
+    std::mutex mutex_;
+    std::map<std::string, Entry> entries_;
+};
+
+} // namespace ocr
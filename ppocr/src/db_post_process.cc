@@ -1,46 +1,123 @@
 #include "db_post_process.h" // NOLINT
+#include "thread_pool.h"
 #include <algorithm>
+#include <cstdint>
+#include <cstdlib>
 #include <utility>
 
-void GetContourArea(std::vector<std::vector<float>> box, float unclip_ratio,
+// Below this many candidates the serial loop is cheaper than dispatching.
+static const int kMinParallelCandidates = 16;
+
+// Scratch buffers for scoring one candidate. CollectBoxes keeps one per
+// worker slot, so a slot reuses them for every candidate it processes and
+// the loop only allocates while they grow.
+struct BoxScratch {
+  std::vector<cv::Point> points;
+  std::vector<cv::Point> hull;
+};
+
+// Runs fn(i, box, scratch) for every candidate i, in parallel on pool when
+// given, and returns the boxes fn accepted in candidate order. Each candidate
+// writes only its own slot, so the result does not depend on scheduling.
+template <class Fn>
+static std::vector<ocr::Quad> CollectBoxes(int num_candidates,
+                                           ocr::ThreadPool *pool, Fn fn) {
+  std::vector<ocr::Quad> slots(num_candidates);
+  std::vector<char> keep(num_candidates, 0);
+  std::vector<BoxScratch> scratch(pool ? std::max(1, pool->maxSlots()) : 1);
+  auto body = [&](int i, int slot) {
+    keep[i] = fn(i, slots[i], scratch[slot]) ? 1 : 0;
+  };
+  if (pool && num_candidates >= kMinParallelCandidates) {
+    pool->parallelFor(num_candidates, body);
+  } else {
+    for (int i = 0; i < num_candidates; i++)
+      body(i, 0);
+  }
+  std::vector<ocr::Quad> boxes;
+  boxes.reserve(num_candidates);
+  for (int i = 0; i < num_candidates; i++) {
+    if (keep[i])
+      boxes.push_back(slots[i]);
+  }
+  return boxes;
+}
+
+static ocr::Quad QuadFromFloatBox(const std::vector<std::vector<float>> &box) {
+  ocr::Quad q;
+  for (int i = 0; i < 4; i++)
+    q.pts[i] = {box[i][0], box[i][1]};
+  q.score = 0.f;
+  q.angle = ocr::QuadAngle(q);
+  return q;
+}
+
+void GetContourArea(const ocr::Quad &box, float unclip_ratio,
                     float &distance) {
   int pts_num = 4;
   float area = 0.0f;
   float dist = 0.0f;
   for (int i = 0; i < pts_num; i++) {
-    area += box[i][0] * box[(i + 1) % pts_num][1] -
-            box[i][1] * box[(i + 1) % pts_num][0];
-    dist += sqrtf((box[i][0] - box[(i + 1) % pts_num][0]) *
-                      (box[i][0] - box[(i + 1) % pts_num][0]) +
-                  (box[i][1] - box[(i + 1) % pts_num][1]) *
-                      (box[i][1] - box[(i + 1) % pts_num][1]));
+    const ocr::QuadPoint &a = box.pts[i];
+    const ocr::QuadPoint &b = box.pts[(i + 1) % pts_num];
+    area += a.x * b.y - a.y * b.x;
+    dist += sqrtf((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
   }
   area = fabs(float(area / 2.0));
 
   distance = area * unclip_ratio / dist;
 }
 
-cv::RotatedRect Unclip(std::vector<std::vector<float>> box,
-                       float unclip_ratio) {
-  float distance = 1.0;
+void GetContourArea(std::vector<std::vector<float>> box, float unclip_ratio,
+                    float &distance) {
+  GetContourArea(QuadFromFloatBox(box), unclip_ratio, distance);
+}
 
-  GetContourArea(box, unclip_ratio, distance);
+bool IsRectangle(const ocr::Quad &box) {
+  const ocr::QuadPoint *p = box.pts;
+  // A quadrilateral is a rectangle iff its diagonals bisect each other and
+  // have the same length.
+  float d02x = p[2].x - p[0].x, d02y = p[2].y - p[0].y;
+  float d13x = p[3].x - p[1].x, d13y = p[3].y - p[1].y;
+  float len02 = sqrtf(d02x * d02x + d02y * d02y);
+  float len13 = sqrtf(d13x * d13x + d13y * d13y);
+  float tol = 1e-3f * std::max(1.0f, std::max(len02, len13));
+  float mid_dx = (p[0].x + p[2].x) - (p[1].x + p[3].x);
+  float mid_dy = (p[0].y + p[2].y) - (p[1].y + p[3].y);
+  return fabs(len02 - len13) <= tol && fabs(mid_dx) <= 2 * tol &&
+         fabs(mid_dy) <= 2 * tol;
+}
+
+cv::RotatedRect UnclipRectangle(const ocr::Quad &box, float distance) {
+  const ocr::QuadPoint *p = box.pts;
+  // Offsetting a rectangle by distance with round joins moves every side
+  // out by distance and only rounds the corners, so the min-area rect of the
+  // result is the same rectangle grown by 2 * distance in each dimension.
+  float ex = p[1].x - p[0].x, ey = p[1].y - p[0].y;
+  float fx = p[3].x - p[0].x, fy = p[3].y - p[0].y;
+  cv::Point2f center((p[0].x + p[1].x + p[2].x + p[3].x) / 4.0f,
+                     (p[0].y + p[1].y + p[2].y + p[3].y) / 4.0f);
+  cv::Size2f size(sqrtf(ex * ex + ey * ey) + 2 * distance,
+                  sqrtf(fx * fx + fy * fy) + 2 * distance);
+  float angle = atan2f(ey, ex) * 180.0f / static_cast<float>(CV_PI);
+  return cv::RotatedRect(center, size, angle);
+}
 
-  ClipperLib::ClipperOffset offset;
-  ClipperLib::Path p;
-  p << ClipperLib::IntPoint(static_cast<int>(box[0][0]),
-                            static_cast<int>(box[0][1]))
-    << ClipperLib::IntPoint(static_cast<int>(box[1][0]),
-                            static_cast<int>(box[1][1]))
-    << ClipperLib::IntPoint(static_cast<int>(box[2][0]),
-                            static_cast<int>(box[2][1]))
-    << ClipperLib::IntPoint(static_cast<int>(box[3][0]),
-                            static_cast<int>(box[3][1]));
+cv::RotatedRect UnclipPolygon(const ocr::Quad &box, float distance) {
+  // One offset object and scratch buffers per thread, reused for every box
+  // so the Clipper path does no heap allocation once warmed up.
+  thread_local ClipperLib::ClipperOffset offset;
+  thread_local ClipperLib::Path p;
+  thread_local ClipperLib::Paths soln;
+  thread_local std::vector<cv::Point2f> points;
+  offset.Clear();
+  p.clear();
+  for (const auto &pt : box.pts)
+    p << ClipperLib::IntPoint(static_cast<int>(pt.x), static_cast<int>(pt.y));
   offset.AddPath(p, ClipperLib::jtRound, ClipperLib::etClosedPolygon);
 
-  ClipperLib::Paths soln;
   offset.Execute(soln, distance);
-  std::vector<cv::Point2f> points;
+  points.clear();
 
   for (int j = 0; j < soln.size(); j++) {
     for (int i = 0; i < soln[soln.size() - 1].size(); i++) {
@@ -52,6 +129,23 @@ cv::RotatedRect Unclip(std::vector<std::vector<float>> box,
   return res;
 }
 
+cv::RotatedRect Unclip(const ocr::Quad &box, float unclip_ratio) {
+  float distance = 1.0;
+
+  GetContourArea(box, unclip_ratio, distance);
+
+  // Boxes from GetMiniBoxes are always rectangles; only general polygons
+  // need the Clipper offset.
+  if (IsRectangle(box))
+    return UnclipRectangle(box, distance);
+  return UnclipPolygon(box, distance);
+}
+
+cv::RotatedRect Unclip(std::vector<std::vector<float>> box,
+                       float unclip_ratio) {
+  return Unclip(QuadFromFloatBox(box), unclip_ratio);
+}
+
 std::vector<std::vector<float>> Mat2Vector(cv::Mat mat) {
   std::vector<std::vector<float>> img_vec;
   std::vector<float> tmp;
@@ -66,13 +160,13 @@ std::vector<std::vector<float>> Mat2Vector(cv::Mat mat) {
   return img_vec;
 }
 
-bool XsortFp32(std::vector<float> a, std::vector<float> b) {
+bool XsortFp32(const std::vector<float> &a, const std::vector<float> &b) {
   if (a[0] != b[0])
     return a[0] < b[0];
   return false;
 }
 
-bool XsortInt(std::vector<int> a, std::vector<int> b) {
+bool XsortInt(const std::vector<int> &a, const std::vector<int> &b) {
   if (a[0] != b[0])
     return a[0] < b[0];
   return false;
@@ -97,138 +191,450 @@ OrderPointsClockwise(std::vector<std::vector<int>> pts) {
   return rect;
 }
 
-std::vector<std::vector<float>> GetMiniBoxes(cv::RotatedRect box, float &ssid) {
-  ssid = std::min(box.size.width, box.size.height);
+ocr::Quad OrderPointsClockwise(const ocr::Quad &quad) {
+  ocr::QuadPoint box[4] = {quad.pts[0], quad.pts[1], quad.pts[2],
+                           quad.pts[3]};
+  std::sort(box, box + 4, [](const ocr::QuadPoint &a,
+                             const ocr::QuadPoint &b) { return a.x < b.x; });
+
+  ocr::QuadPoint leftmost[2] = {box[0], box[1]};
+  ocr::QuadPoint rightmost[2] = {box[2], box[3]};
+
+  if (leftmost[0].y > leftmost[1].y)
+    std::swap(leftmost[0], leftmost[1]);
 
-  cv::Mat points;
-  cv::boxPoints(box, points);
+  if (rightmost[0].y > rightmost[1].y)
+    std::swap(rightmost[0], rightmost[1]);
 
-  auto array = Mat2Vector(points);
-  std::sort(array.begin(), array.end(), XsortFp32);
+  ocr::Quad rect = quad;
+  rect.pts[0] = leftmost[0];
+  rect.pts[1] = rightmost[0];
+  rect.pts[2] = rightmost[1];
+  rect.pts[3] = leftmost[1];
+  rect.angle = ocr::QuadAngle(rect);
+  return rect;
+}
 
-  std::vector<float> idx1 = array[0], idx2 = array[1], idx3 = array[2],
-                     idx4 = array[3];
-  if (array[3][1] <= array[2][1]) {
-    idx2 = array[3];
-    idx3 = array[2];
+ocr::Quad GetMiniQuad(const cv::RotatedRect &box, float &ssid) {
+  ssid = std::min(box.size.width, box.size.height);
+
+  cv::Point2f array[4];
+  box.points(array);
+  std::sort(array, array + 4, [](const cv::Point2f &a, const cv::Point2f &b) {
+    return a.x < b.x;
+  });
+
+  int idx1, idx2, idx3, idx4;
+  if (array[3].y <= array[2].y) {
+    idx2 = 3;
+    idx3 = 2;
   } else {
-    idx2 = array[2];
-    idx3 = array[3];
+    idx2 = 2;
+    idx3 = 3;
   }
-  if (array[1][1] <= array[0][1]) {
-    idx1 = array[1];
-    idx4 = array[0];
+  if (array[1].y <= array[0].y) {
+    idx1 = 1;
+    idx4 = 0;
   } else {
-    idx1 = array[0];
-    idx4 = array[1];
+    idx1 = 0;
+    idx4 = 1;
   }
 
-  array[0] = idx1;
-  array[1] = idx2;
-  array[2] = idx3;
-  array[3] = idx4;
+  ocr::Quad quad;
+  const int order[4] = {idx1, idx2, idx3, idx4};
+  for (int i = 0; i < 4; i++)
+    quad.pts[i] = {array[order[i]].x, array[order[i]].y};
+  quad.score = 0.f;
+  quad.angle = ocr::QuadAngle(quad);
+  return quad;
+}
 
+std::vector<std::vector<float>> GetMiniBoxes(cv::RotatedRect box, float &ssid) {
+  ocr::Quad quad = GetMiniQuad(box, ssid);
+  std::vector<std::vector<float>> array(4);
+  for (int i = 0; i < 4; i++)
+    array[i] = {quad.pts[i].x, quad.pts[i].y};
   return array;
 }
 
-float BoxScoreFast(std::vector<std::vector<float>> box_array, cv::Mat pred) {
-  auto array = box_array;
-  int width = pred.cols;
-  int height = pred.rows;
-
-  float box_x[4] = {array[0][0], array[1][0], array[2][0], array[3][0]};
-  float box_y[4] = {array[0][1], array[1][1], array[2][1], array[3][1]};
-
-  int xmin = clamp(
-      static_cast<int>(std::floor(*(std::min_element(box_x, box_x + 4)))), 0,
-      width - 1);
-  int xmax =
-      clamp(static_cast<int>(std::ceil(*(std::max_element(box_x, box_x + 4)))),
-            0, width - 1);
-  int ymin = clamp(
-      static_cast<int>(std::floor(*(std::min_element(box_y, box_y + 4)))), 0,
-      height - 1);
-  int ymax =
-      clamp(static_cast<int>(std::ceil(*(std::max_element(box_y, box_y + 4)))),
-            0, height - 1);
-
-  cv::Mat mask;
-  mask = cv::Mat::zeros(ymax - ymin + 1, xmax - xmin + 1, CV_8UC1);
-
-  cv::Point root_point[4];
-  root_point[0] = cv::Point(static_cast<int>(array[0][0]) - xmin,
-                            static_cast<int>(array[0][1]) - ymin);
-  root_point[1] = cv::Point(static_cast<int>(array[1][0]) - xmin,
-                            static_cast<int>(array[1][1]) - ymin);
-  root_point[2] = cv::Point(static_cast<int>(array[2][0]) - xmin,
-                            static_cast<int>(array[2][1]) - ymin);
-  root_point[3] = cv::Point(static_cast<int>(array[3][0]) - xmin,
-                            static_cast<int>(array[3][1]) - ymin);
-  const cv::Point *ppt[1] = {root_point};
-  int npt[] = {4};
+// The helpers below reproduce cv::fillPoly (LINE_8, shift 0) for a polygon
+// that lies inside the image: the mask is the union of every edge drawn with
+// cv::line and the even-odd interior spans of FillEdgeCollection (16.16 fixed
+// point). Polygons that leave the image go through the real mask instead, as
+// fillPoly's edge clipping is not reproduced here.
+static const int kXYShift = 16;
+
+// One run of covered pixels [x0, x1] on row y of the mask.
+struct MaskRun {
+  int y, x0, x1;
+  bool operator<(const MaskRun &o) const {
+    return y != o.y ? y < o.y : x0 < o.x0;
+  }
+};
+
+// Pixels of cv::line(p0, p1) with LINE_8 (cv::LineIterator, left to right),
+// appended as one run per row.
+static void AppendLineRuns(int x0, int y0, int x1, int y1,
+                           std::vector<MaskRun> &runs) {
+  if (x1 < x0) {
+    std::swap(x0, x1);
+    std::swap(y0, y1);
+  }
+  int dx = x1 - x0, dy = y1 - y0;
+  const int sy = dy < 0 ? -1 : 1;
+  dy = std::abs(dy);
+  // Major / minor steps; the minor step is taken when err goes negative.
+  int major_x = 1, major_y = 0, minor_x = 0, minor_y = sy;
+  if (dy > dx) {
+    std::swap(dx, dy);
+    major_x = 0, major_y = sy, minor_x = 1, minor_y = 0;
+  }
+  int err = dx - (dy + dy);
+  int x = x0, y = y0;
+  MaskRun run{y, x, x};
+  for (int i = 0; i <= dx; i++) {
+    if (y != run.y) {
+      runs.push_back(run);
+      run = MaskRun{y, x, x};
+    }
+    run.x0 = std::min(run.x0, x);
+    run.x1 = std::max(run.x1, x);
+    const bool minor = err < 0;
+    err += -(dy + dy) + (minor ? dx + dx : 0);
+    x += major_x + (minor ? minor_x : 0);
+    y += major_y + (minor ? minor_y : 0);
+  }
+  runs.push_back(run);
+}
+
+// The old scorer: cv::fillPoly into a mask over the bounding box crop, then
+// cv::mean under it.
+static float PolygonMaskScore(const cv::Point *pts, int n, int xmin, int ymin,
+                              int xmax, int ymax, const cv::Mat &pred) {
+  cv::Mat mask = cv::Mat::zeros(ymax - ymin + 1, xmax - xmin + 1, CV_8UC1);
+  thread_local std::vector<cv::Point> shifted;
+  shifted.resize(n);
+  for (int i = 0; i < n; ++i)
+    shifted[i] = cv::Point(pts[i].x - xmin, pts[i].y - ymin);
+  const cv::Point *ppt[1] = {shifted.data()};
+  int npt[] = {n};
   cv::fillPoly(mask, ppt, npt, 1, cv::Scalar(1));
+  return static_cast<float>(
+      cv::mean(pred(cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1)),
+               mask)[0]);
+}
+
+float PolygonMeanScore(const cv::Point *pts, int n, const cv::Mat &pred) {
+  if (n <= 0)
+    return 0.f;
+  // Same crop as the old mask scorer: the polygon's bounding box clamped to
+  // pred, with the polygon in crop coordinates.
+  int xmin = pts[0].x, xmax = pts[0].x, ymin = pts[0].y, ymax = pts[0].y;
+  for (int i = 1; i < n; ++i) {
+    xmin = std::min(xmin, pts[i].x);
+    xmax = std::max(xmax, pts[i].x);
+    ymin = std::min(ymin, pts[i].y);
+    ymax = std::max(ymax, pts[i].y);
+  }
+  const bool inside =
+      xmin >= 0 && ymin >= 0 && xmax < pred.cols && ymax < pred.rows;
+  xmin = std::min(std::max(xmin, 0), pred.cols - 1);
+  xmax = std::min(std::max(xmax, 0), pred.cols - 1);
+  ymin = std::min(std::max(ymin, 0), pred.rows - 1);
+  ymax = std::min(std::max(ymax, 0), pred.rows - 1);
+  if (!inside)
+    return PolygonMaskScore(pts, n, xmin, ymin, xmax, ymax, pred);
+
+  // Per-thread scratch, reused across calls so scoring does no heap work
+  // once the buffers have grown to the largest polygon seen.
+  struct Edge {
+    int64_t x, dx;
+    int y0, y1;
+  };
+  thread_local std::vector<Edge> edges;
+  thread_local std::vector<MaskRun> runs;
+  thread_local std::vector<int64_t> xs;
+  edges.clear();
+  runs.clear();
+
+  for (int i = 0; i < n; ++i) {
+    const cv::Point &a = pts[i == 0 ? n - 1 : i - 1];
+    const cv::Point &b = pts[i];
+    AppendLineRuns(a.x - xmin, a.y - ymin, b.x - xmin, b.y - ymin, runs);
+    if (a.y == b.y)
+      continue;
+    const int64_t ax = int64_t(a.x - xmin) << kXYShift;
+    const int64_t bx = int64_t(b.x - xmin) << kXYShift;
+    Edge e;
+    e.dx = (bx - ax) / (b.y - a.y);
+    if (a.y < b.y) {
+      e.y0 = a.y - ymin, e.y1 = b.y - ymin, e.x = ax;
+    } else {
+      e.y0 = b.y - ymin, e.y1 = a.y - ymin, e.x = bx;
+    }
+    edges.push_back(e);
+  }
 
-  cv::Mat croppedImg;
-  pred(cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1))
-      .copyTo(croppedImg);
+  // Interior: even-odd pairs of the active edges on each row, from
+  // ceil(left x) to floor(right x); an edge covers rows [y0, y1).
+  if (edges.size() >= 2) {
+    for (int y = 0; y < ymax - ymin + 1; ++y) {
+      xs.clear();
+      for (const Edge &e : edges) {
+        if (y >= e.y0 && y < e.y1)
+          xs.push_back(e.x + (y - e.y0) * e.dx);
+      }
+      std::sort(xs.begin(), xs.end());
+      for (size_t i = 0; i + 1 < xs.size(); i += 2) {
+        const int x0 = static_cast<int>((xs[i] + (1 << kXYShift) - 1) >>
+                                        kXYShift);
+        const int x1 = static_cast<int>(xs[i + 1] >> kXYShift);
+        if (x0 <= x1)
+          runs.push_back(MaskRun{y, x0, x1});
+      }
+    }
+  }
 
-  auto score = cv::mean(croppedImg, mask)[0];
-  return score;
+  // Sum pred over the union of the runs, row by row.
+  std::sort(runs.begin(), runs.end());
+  double sum = 0.0;
+  long count = 0;
+  int row_y = -1, covered = -1; // last x already summed on row_y
+  for (const MaskRun &run : runs) {
+    if (run.y != row_y) {
+      row_y = run.y;
+      covered = -1;
+    }
+    const int from = std::max(run.x0, covered + 1);
+    if (from > run.x1)
+      continue;
+    const float *row = pred.ptr<float>(ymin + run.y) + xmin;
+    for (int x = from; x <= run.x1; ++x)
+      sum += row[x];
+    count += run.x1 - from + 1;
+    covered = run.x1;
+  }
+  return count > 0 ? static_cast<float>(sum / count) : 0.f;
+}
+
+float BoxScoreFast(const ocr::Quad &box, const cv::Mat &pred) {
+  cv::Point pts[4];
+  for (int i = 0; i < 4; ++i)
+    pts[i] = cv::Point(static_cast<int>(box.pts[i].x),
+                       static_cast<int>(box.pts[i].y));
+  return PolygonMeanScore(pts, 4, pred);
+}
+
+float BoxScoreFast(std::vector<std::vector<float>> box_array, cv::Mat pred) {
+  return BoxScoreFast(QuadFromFloatBox(box_array), pred);
 }
 
 float PolygonScoreAcc(std::vector<cv::Point> contour, cv::Mat pred) {
-  int width = pred.cols;
-  int height = pred.rows;
-  std::vector<float> box_x;
-  std::vector<float> box_y;
-  for (int i = 0; i < contour.size(); ++i) {
-    box_x.push_back(contour[i].x);
-    box_y.push_back(contour[i].y);
+  return PolygonMeanScore(contour.data(), static_cast<int>(contour.size()),
+                          pred);
+}
+
+// Unclip a mini box and scale it to the pred map size. Returns false when the
+// expanded box is too small to keep.
+static bool UnclipToBox(const ocr::Quad &box_for_unclip, float unclip_ratio,
+                        int min_size, int width, int height, int dest_width,
+                        int dest_height, ocr::Quad &intcliparray) {
+  // start for unclip
+  cv::RotatedRect points = Unclip(box_for_unclip, unclip_ratio);
+  if (points.size.height < 1.001 && points.size.width < 1.001)
+    return false;
+  // end for unclip
+
+  float ssid;
+  cv::RotatedRect clipbox = points;
+  auto cliparray = GetMiniQuad(clipbox, ssid);
+
+  if (ssid < min_size + 2)
+    return false;
+
+  // Points stay integer valued, as in the old vector<int> boxes.
+  for (int num_pt = 0; num_pt < 4; num_pt++) {
+    intcliparray.pts[num_pt] = {
+        float(static_cast<int>(
+            clamp(roundf(cliparray.pts[num_pt].x / float(width) *
+                         float(dest_width)),
+                  float(0), float(dest_width)))),
+        float(static_cast<int>(
+            clamp(roundf(cliparray.pts[num_pt].y / float(height) *
+                         float(dest_height)),
+                  float(0), float(dest_height))))};
   }
+  intcliparray.angle = ocr::QuadAngle(intcliparray);
+  return true;
+}
 
-  int xmin =
-      clamp(int(std::floor(*(std::min_element(box_x.begin(), box_x.end())))), 0,
-            width - 1);
-  int xmax =
-      clamp(int(std::ceil(*(std::max_element(box_x.begin(), box_x.end())))), 0,
-            width - 1);
-  int ymin =
-      clamp(int(std::floor(*(std::min_element(box_y.begin(), box_y.end())))), 0,
-            height - 1);
-  int ymax =
-      clamp(int(std::ceil(*(std::max_element(box_y.begin(), box_y.end())))), 0,
-            height - 1);
-
-  cv::Mat mask;
-  mask = cv::Mat::zeros(ymax - ymin + 1, xmax - xmin + 1, CV_8UC1);
-
-  cv::Point *rook_point = new cv::Point[contour.size()];
-
-  for (int i = 0; i < contour.size(); ++i) {
-    rook_point[i] = cv::Point(int(box_x[i]) - xmin, int(box_y[i]) - ymin);
+std::vector<ocr::Quad>
+BoxesFromComponents(const cv::Mat pred, const cv::Mat bitmap,
+                    std::map<std::string, double> Config,
+                    ocr::ThreadPool *pool) {
+  const int min_size = 3;
+  const int max_candidates = 1000;
+  const float box_thresh = static_cast<float>(Config["det_db_box_thresh"]);
+  const float unclip_ratio = static_cast<float>(Config["det_db_unclip_ratio"]);
+  const int det_use_polygon_score = int(Config["det_use_polygon_score"]);
+
+  const int width = bitmap.cols;
+  const int height = bitmap.rows;
+
+  // Pass 1: run-length labelling with union-find (8-connectivity). Each run
+  // is a horizontal segment [x0, x1] of foreground pixels on row y.
+  std::vector<int> run_x0, run_x1, run_y, parent;
+  std::vector<float> run_sum;
+  auto find = [&parent](int i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+  int prev_begin = 0, prev_end = 0;
+  for (int y = 0; y < height; y++) {
+    const unsigned char *row = bitmap.ptr<unsigned char>(y);
+    const float *prow = pred.ptr<float>(y);
+    int cur_begin = static_cast<int>(run_x0.size());
+    int p = prev_begin;
+    for (int x = 0; x < width;) {
+      if (!row[x]) {
+        x++;
+        continue;
+      }
+      int x0 = x;
+      float sum = 0.f;
+      while (x < width && row[x]) {
+        sum += prow[x];
+        x++;
+      }
+      int x1 = x - 1;
+      int id = static_cast<int>(run_x0.size());
+      run_x0.push_back(x0);
+      run_x1.push_back(x1);
+      run_y.push_back(y);
+      run_sum.push_back(sum);
+      parent.push_back(id);
+      // Runs of the previous row touching [x0 - 1, x1 + 1] belong to the
+      // same component.
+      while (p < prev_end && run_x1[p] < x0 - 1)
+        p++;
+      for (int q = p; q < prev_end && run_x0[q] <= x1 + 1; q++) {
+        int a = find(q), b = find(id);
+        if (a != b)
+          parent[std::max(a, b)] = std::min(a, b);
+      }
+    }
+    prev_begin = cur_begin;
+    prev_end = static_cast<int>(run_x0.size());
   }
-  const cv::Point *ppt[1] = {rook_point};
-  int npt[] = {int(contour.size())};
 
-  cv::fillPoly(mask, ppt, npt, 1, cv::Scalar(1));
+  // Pass 2: accumulate per-component statistics in flat arrays.
+  const int num_runs = static_cast<int>(run_x0.size());
+  std::vector<int> comp_of_run(num_runs), comp_root;
+  std::vector<int> label(num_runs, -1);
+  for (int i = 0; i < num_runs; i++) {
+    int r = find(i);
+    if (label[r] < 0) {
+      label[r] = static_cast<int>(comp_root.size());
+      comp_root.push_back(r);
+    }
+    comp_of_run[i] = label[r];
+  }
+  const int num_comps = static_cast<int>(comp_root.size());
+  std::vector<int> area(num_comps, 0), pt_count(num_comps, 0);
+  std::vector<int> xmin(num_comps, width), xmax(num_comps, -1);
+  std::vector<int> ymin(num_comps, height), ymax(num_comps, -1);
+  std::vector<double> pred_sum(num_comps, 0.0);
+  for (int i = 0; i < num_runs; i++) {
+    int c = comp_of_run[i];
+    area[c] += run_x1[i] - run_x0[i] + 1;
+    pred_sum[c] += run_sum[i];
+    xmin[c] = std::min(xmin[c], run_x0[i]);
+    xmax[c] = std::max(xmax[c], run_x1[i]);
+    ymin[c] = std::min(ymin[c], run_y[i]);
+    ymax[c] = std::max(ymax[c], run_y[i]);
+    pt_count[c] += 2;
+  }
 
-  cv::Mat croppedImg;
-  pred(cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1))
-      .copyTo(croppedImg);
-  float score = cv::mean(croppedImg, mask)[0];
+  // Rank candidates by mean probability and keep the best max_candidates.
+  // Components whose bounding box is smaller than min_size^2 cannot have a
+  // min-area rect with short side >= min_size, so they are dropped early.
+  std::vector<int> cand;
+  std::vector<float> mean_score(num_comps);
+  for (int c = 0; c < num_comps; c++) {
+    mean_score[c] = static_cast<float>(pred_sum[c] / area[c]);
+    int bw = xmax[c] - xmin[c] + 1, bh = ymax[c] - ymin[c] + 1;
+    if (bw * bh < min_size * min_size)
+      continue;
+    cand.push_back(c);
+  }
+  auto by_score = [&mean_score](int a, int b) {
+    if (mean_score[a] != mean_score[b])
+      return mean_score[a] > mean_score[b];
+    return a < b;
+  };
+  if (static_cast<int>(cand.size()) > max_candidates) {
+    std::nth_element(cand.begin(), cand.begin() + max_candidates, cand.end(),
+                     by_score);
+    cand.resize(max_candidates);
+  }
+  // Keep the output in scan order (top-to-bottom) like the contour path.
+  std::sort(cand.begin(), cand.end());
+
+  // Run end points of every component, packed contiguously; the hull of the
+  // run ends is the hull of the component.
+  std::vector<int> pt_offset(num_comps + 1, 0);
+  for (int c = 0; c < num_comps; c++)
+    pt_offset[c + 1] = pt_offset[c] + pt_count[c];
+  std::vector<cv::Point> points(pt_offset[num_comps]);
+  std::vector<int> fill(pt_offset.begin(), pt_offset.end() - 1);
+  for (int i = 0; i < num_runs; i++) {
+    int c = comp_of_run[i];
+    points[fill[c]++] = cv::Point(run_x0[i], run_y[i]);
+    points[fill[c]++] = cv::Point(run_x1[i], run_y[i]);
+  }
 
-  delete[] rook_point;
-  return score;
+  return CollectBoxes(
+      static_cast<int>(cand.size()), pool,
+      [&](int i, ocr::Quad &intcliparray, BoxScratch &scratch) {
+        int c = cand[i];
+        std::vector<cv::Point> &hull = scratch.hull;
+        scratch.points.assign(points.begin() + pt_offset[c],
+                              points.begin() + pt_offset[c + 1]);
+        cv::convexHull(scratch.points, hull);
+        if (hull.size() <= 2)
+          return false;
+
+        float ssid;
+        cv::RotatedRect box = cv::minAreaRect(hull);
+        auto array = GetMiniQuad(box, ssid);
+        if (ssid < min_size)
+          return false;
+
+        float score = det_use_polygon_score ? mean_score[c]
+                                            : BoxScoreFast(array, pred);
+        if (score < box_thresh)
+          return false;
+
+        intcliparray.score = score;
+        return UnclipToBox(array, unclip_ratio, min_size, width, height,
+                           pred.cols, pred.rows, intcliparray);
+      });
 }
 
-std::vector<std::vector<std::vector<int>>>
+std::vector<ocr::Quad>
 BoxesFromBitmap(const cv::Mat pred, const cv::Mat bitmap,
-                std::map<std::string, double> Config) {
+                std::map<std::string, double> Config,
+                ocr::ThreadPool *pool) {
   const int min_size = 3;
   const int max_candidates = 1000;
   const float box_thresh = static_cast<float>(Config["det_db_box_thresh"]);
   const float unclip_ratio = static_cast<float>(Config["det_db_unclip_ratio"]);
   const int det_use_polygon_score = int(Config["det_use_polygon_score"]);
+  if (int(Config["det_box_extractor"]) == 1)
+    return BoxesFromComponents(pred, bitmap, Config, pool);
 
   int width = bitmap.cols;
   int height = bitmap.rows;
@@ -242,96 +648,75 @@ BoxesFromBitmap(const cv::Mat pred, const cv::Mat bitmap,
   int num_contours =
       contours.size() >= max_candidates ? max_candidates : contours.size();
 
-  std::vector<std::vector<std::vector<int>>> boxes;
-
-  for (int i = 0; i < num_contours; i++) {
-    float ssid;
-    if (contours[i].size() <= 2)
-      continue;
-
-    cv::RotatedRect box = cv::minAreaRect(contours[i]);
-    auto array = GetMiniBoxes(box, ssid);
-
-    auto box_for_unclip = array;
-    // end get_mini_box
-
-    if (ssid < min_size) {
-      continue;
-    }
-
-    float score;
-    if (det_use_polygon_score) {
-      score = PolygonScoreAcc(contours[i], pred);
-    } else {
-      score = BoxScoreFast(array, pred);
-    }
-    // end box_score_fast
-    if (score < box_thresh)
-      continue;
-
-    // start for unclip
-    cv::RotatedRect points = Unclip(box_for_unclip, unclip_ratio);
-    if (points.size.height < 1.001 && points.size.width < 1.001)
-      continue;
-    // end for unclip
-
-    cv::RotatedRect clipbox = points;
-    auto cliparray = GetMiniBoxes(clipbox, ssid);
-
-    if (ssid < min_size + 2)
-      continue;
-
-    int dest_width = pred.cols;
-    int dest_height = pred.rows;
-    std::vector<std::vector<int>> intcliparray;
-
-    for (int num_pt = 0; num_pt < 4; num_pt++) {
-      std::vector<int> a{
-          static_cast<int>(clamp(
-              roundf(cliparray[num_pt][0] / float(width) * float(dest_width)),
-              float(0), float(dest_width))),
-          static_cast<int>(clamp(
-              roundf(cliparray[num_pt][1] / float(height) * float(dest_height)),
-              float(0), float(dest_height)))};
-      intcliparray.push_back(a);
-    }
-    boxes.push_back(intcliparray);
-
-  } // end for
-  return boxes;
+  return CollectBoxes(
+      num_contours, pool,
+      [&](int i, ocr::Quad &intcliparray, BoxScratch &) {
+        float ssid;
+        if (contours[i].size() <= 2)
+          return false;
+
+        cv::RotatedRect box = cv::minAreaRect(contours[i]);
+        auto array = GetMiniQuad(box, ssid);
+
+        const auto &box_for_unclip = array;
+        // end get_mini_box
+
+        if (ssid < min_size) {
+          return false;
+        }
+
+        float score;
+        if (det_use_polygon_score) {
+          score = PolygonMeanScore(contours[i].data(),
+                                   static_cast<int>(contours[i].size()), pred);
+        } else {
+          score = BoxScoreFast(array, pred);
+        }
+        // end box_score_fast
+        if (score < box_thresh)
+          return false;
+
+        intcliparray.score = score;
+        return UnclipToBox(box_for_unclip, unclip_ratio, min_size, width,
+                           height, pred.cols, pred.rows, intcliparray);
+      }); // end for
 }
 
-std::vector<std::vector<std::vector<int>>>
-FilterTagDetRes(std::vector<std::vector<std::vector<int>>> boxes, float ratio_h,
-                float ratio_w, cv::Mat srcimg) {
+std::vector<ocr::Quad> FilterTagDetRes(std::vector<ocr::Quad> boxes,
+                                       float ratio_h, float ratio_w,
+                                       const cv::Mat &srcimg) {
   int oriimg_h = srcimg.rows;
   int oriimg_w = srcimg.cols;
 
-  std::vector<std::vector<std::vector<int>>> root_points;
-  for (int n = 0; n < static_cast<int>(boxes.size()); n++) {
-    boxes[n] = OrderPointsClockwise(boxes[n]);
-    for (int m = 0; m < static_cast<int>(boxes[0].size()); m++) {
-      boxes[n][m][0] /= ratio_w;
-      boxes[n][m][1] /= ratio_h;
-
-      boxes[n][m][0] =
-          static_cast<int>(std::min(std::max(boxes[n][m][0], 0), oriimg_w - 1));
-      boxes[n][m][1] =
-          static_cast<int>(std::min(std::max(boxes[n][m][1], 0), oriimg_h - 1));
+  std::vector<ocr::Quad> root_points;
+  root_points.reserve(boxes.size());
+  for (auto &box : boxes) {
+    box = OrderPointsClockwise(box);
+    // Same truncation as the old int boxes: x = int(x / ratio), clamped.
+    for (auto &pt : box.pts) {
+      int x = static_cast<int>(static_cast<int>(pt.x) / ratio_w);
+      int y = static_cast<int>(static_cast<int>(pt.y) / ratio_h);
+      pt.x = float(std::min(std::max(x, 0), oriimg_w - 1));
+      pt.y = float(std::min(std::max(y, 0), oriimg_h - 1));
     }
-  }
-
-  for (int n = 0; n < boxes.size(); n++) {
-    int rect_width, rect_height;
-    rect_width =
-        static_cast<int>(sqrt(pow(boxes[n][0][0] - boxes[n][1][0], 2) +
-                              pow(boxes[n][0][1] - boxes[n][1][1], 2)));
-    rect_height =
-        static_cast<int>(sqrt(pow(boxes[n][0][0] - boxes[n][3][0], 2) +
-                              pow(boxes[n][0][1] - boxes[n][3][1], 2)));
+    box.angle = ocr::QuadAngle(box);
+
+    int rect_width =
+        static_cast<int>(sqrt(pow(box.pts[0].x - box.pts[1].x, 2) +
+                              pow(box.pts[0].y - box.pts[1].y, 2)));
+    int rect_height =
+        static_cast<int>(sqrt(pow(box.pts[0].x - box.pts[3].x, 2) +
+                              pow(box.pts[0].y - box.pts[3].y, 2)));
     if (rect_width <= 4 || rect_height <= 4)
       continue;
-    root_points.push_back(boxes[n]);
+    root_points.push_back(box);
   }
   return root_points;
 }
+
+std::vector<std::vector<std::vector<int>>>
+FilterTagDetRes(std::vector<std::vector<std::vector<int>>> boxes, float ratio_h,
+                float ratio_w, cv::Mat srcimg) {
+  return ocr::QuadsToBoxes(
+      FilterTagDetRes(ocr::BoxesToQuads(boxes), ratio_h, ratio_w, srcimg));
+}
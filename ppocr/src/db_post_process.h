@@ -9,6 +9,11 @@
 #include "opencv2/core.hpp"
 #include "opencv2/imgcodecs.hpp"
 #include "opencv2/imgproc.hpp"
+#include "quad.h"
+
+namespace ocr {
+class ThreadPool;
+} // namespace ocr
 
 template <class T> T clamp(T x, T min, T max) {
   if (x > max)
@@ -20,28 +25,85 @@ template <class T> T clamp(T x, T min, T max) {
 
 std::vector<std::vector<float>> Mat2Vector(cv::Mat mat);
 
+void GetContourArea(const ocr::Quad &box, float unclip_ratio,
+                    float &distance);
+
 void GetContourArea(std::vector<std::vector<float>> box, float unclip_ratio,
                     float &distance);
 
+// True if the four points (in order around the shape) form a rectangle.
+bool IsRectangle(const ocr::Quad &box);
+
+// Closed-form Unclip for a rectangle: the rectangle grown by distance on
+// every side, which is what minAreaRect of the round-joined Clipper offset
+// gives up to integer rounding.
+cv::RotatedRect UnclipRectangle(const ocr::Quad &box, float distance);
+
+// Offsets box (corners truncated to int) by distance with round joins via
+// ClipperOffset and returns the min-area rect of the result.
+cv::RotatedRect UnclipPolygon(const ocr::Quad &box, float distance);
+
+// Expands box by GetContourArea's distance and returns the min-area rect of
+// the result. Rectangles take the UnclipRectangle fast path, other polygons
+// go through UnclipPolygon.
+cv::RotatedRect Unclip(const ocr::Quad &box, float unclip_ratio);
+
 cv::RotatedRect Unclip(std::vector<std::vector<float>> box, float unclip_ratio);
 
 std::vector<std::vector<float>> Mat2Vector(cv::Mat mat);
 
-bool XsortFp32(std::vector<float> a, std::vector<float> b);
+bool XsortFp32(const std::vector<float> &a, const std::vector<float> &b);
 
-bool XsortInt(std::vector<int> a, std::vector<int> b);
+bool XsortInt(const std::vector<int> &a, const std::vector<int> &b);
 
 std::vector<std::vector<int>>
 OrderPointsClockwise(std::vector<std::vector<int>> pts);
 
+ocr::Quad OrderPointsClockwise(const ocr::Quad &quad);
+
+// Corners of box as tl, tr, br, bl; ssid is the short side. No heap use.
+ocr::Quad GetMiniQuad(const cv::RotatedRect &box, float &ssid);
+
 std::vector<std::vector<float>> GetMiniBoxes(cv::RotatedRect box, float &ssid);
 
+// Mean of pred over the pixels cv::fillPoly would cover for the polygon
+// pts[0..n), the same value as the old mask + cv::mean scorer. Polygons inside
+// pred are rasterized scanline by scanline straight from the edges, matching
+// fillPoly's LINE_8 outline and interior spans (no mask, no ROI copy, no
+// per-call allocation); polygons that leave pred fall back to the mask.
+float PolygonMeanScore(const cv::Point *pts, int n, const cv::Mat &pred);
+
+float BoxScoreFast(const ocr::Quad &box, const cv::Mat &pred);
+
 float BoxScoreFast(std::vector<std::vector<float>> box_array, cv::Mat pred);
 
-std::vector<std::vector<std::vector<int>>>
+float PolygonScoreAcc(std::vector<cv::Point> contour, cv::Mat pred);
+
+// Config["det_box_extractor"]: 0 = findContours per contour (default),
+// 1 = BoxesFromComponents.
+// When pool is given, candidates are scored and unclipped in parallel on it;
+// the output order is the same as the serial loop.
+// Boxes are in pred coordinates; Quad::score holds the candidate's score.
+std::vector<ocr::Quad>
 BoxesFromBitmap(const cv::Mat pred, const cv::Mat bitmap,
-                std::map<std::string, double> Config);
+                std::map<std::string, double> Config,
+                ocr::ThreadPool *pool = nullptr);
+
+// Single-pass run-length connected-component extractor. Accumulates area,
+// pred sum and run end points per component in flat arrays, keeps the
+// max_candidates components with the highest mean probability and builds
+// boxes from the convex hull of each. With det_use_polygon_score the score
+// is the component's mean probability, otherwise BoxScoreFast.
+std::vector<ocr::Quad>
+BoxesFromComponents(const cv::Mat pred, const cv::Mat bitmap,
+                    std::map<std::string, double> Config,
+                    ocr::ThreadPool *pool = nullptr);
+
+std::vector<ocr::Quad> FilterTagDetRes(std::vector<ocr::Quad> boxes,
+                                       float ratio_h, float ratio_w,
+                                       const cv::Mat &srcimg);
 
+// Adapter for the old nested-vector box format.
 std::vector<std::vector<std::vector<int>>>
 FilterTagDetRes(std::vector<std::vector<std::vector<int>>> boxes, float ratio_h,
                 float ratio_w, cv::Mat srcimg);
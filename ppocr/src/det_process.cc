@@ -1,7 +1,14 @@
 #include "det_process.h"
 #include "db_post_process.h"  // Chứa BoxesFromBitmap, FilterTagDetRes,...
+#include "det_tiling.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
 #include "opencv2/imgproc.hpp"  // Để sử dụng cv::resize, cv::copyMakeBorder, cv::threshold, cv::polylines, cv::boundingRect,...
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <tuple>
 #include <iostream>
 
 // Bao gồm rec_process để sử dụng recognition.
@@ -10,10 +17,10 @@
 namespace ocr {
 using namespace paddle::lite_api;
 
-cv::Mat CropBox(const cv::Mat &src, const std::vector<std::vector<int>> &box) {
+cv::Mat CropBox(const cv::Mat &src, const Quad &box) {
     std::vector<cv::Point2f> src_pts;
-    for (const auto &pt : box) {
-        src_pts.push_back(cv::Point2f(static_cast<float>(pt[0]), static_cast<float>(pt[1])));
+    for (const auto &pt : box.pts) {
+        src_pts.push_back(cv::Point2f(pt.x, pt.y));
     }
     float widthA = std::hypot(src_pts[0].x - src_pts[1].x, src_pts[0].y - src_pts[1].y);
     float widthB = std::hypot(src_pts[2].x - src_pts[3].x, src_pts[2].y - src_pts[3].y);
@@ -36,6 +43,10 @@ cv::Mat CropBox(const cv::Mat &src, const std::vector<std::vector<int>> &box) {
     return cropped;
 }
 
+cv::Mat CropBox(const cv::Mat &src, const std::vector<std::vector<int>> &box) {
+    return CropBox(src, BoxToQuad(box));
+}
+
 DetProcess::DetProcess(const std::string &model_path, int cpu_threads, const std::string &cpu_power_mode) {
     MobileConfig config;
     config.set_model_from_file(model_path);
@@ -49,17 +60,38 @@ DetProcess::DetProcess(const std::string &model_path, int cpu_threads, const std
     predictor_ = CreatePaddlePredictor<MobileConfig>(config);
 }
 
-cv::Mat DetProcess::letterboxResize(const cv::Mat &img, int target_size, float &scale, int &pad_left, int &pad_top) {
+DetProcess::~DetProcess() = default;
+
+namespace {
+
+// Đọc khóa tùy chọn trong config, trả về giá trị mặc định nếu không có.
+double ConfigOr(const std::map<std::string, double> &config, const std::string &key, double def) {
+    auto it = config.find(key);
+    return it == config.end() ? def : it->second;
+}
+
+// Cạnh dài của shape input cho một ROI có cạnh dài native pixel trong lượt tinh: mức lớn nhất không vượt
+// native (không phóng to ROI) trong tập 32, 64, rồi bội số của 128 đến max_side_len, để số shape hữu hạn.
+int FineSideLength(int native, int max_side_len) {
+    const int max_side = std::max(32, max_side_len / 32 * 32);
+    int side = native >= 128 ? native / 128 * 128 : (native >= 64 ? 64 : 32);
+    return std::min(side, max_side);
+}
+
+} // namespace
+
+cv::Mat DetProcess::letterboxResize(const cv::Mat &img, int target_w, int target_h, float &scale, int &pad_left, int &pad_top) const {
     int orig_w = img.cols;
     int orig_h = img.rows;
-    scale = static_cast<float>(target_size) / std::max(orig_w, orig_h);
-    int new_w = static_cast<int>(orig_w * scale);
-    int new_h = static_cast<int>(orig_h * scale);
+    scale = std::min(static_cast<float>(target_w) / orig_w, static_cast<float>(target_h) / orig_h);
+    // Ảnh rất mảnh: cạnh ngắn không được làm tròn về 0.
+    int new_w = std::max(1, static_cast<int>(orig_w * scale));
+    int new_h = std::max(1, static_cast<int>(orig_h * scale));
     cv::Mat resized;
     cv::resize(img, resized, cv::Size(new_w, new_h));
     
-    int pad_w = target_size - new_w;
-    int pad_h = target_size - new_h;
+    int pad_w = target_w - new_w;
+    int pad_h = target_h - new_h;
     pad_left = pad_w / 2;
     pad_top  = pad_h / 2;
     cv::Mat padded;
@@ -69,7 +101,7 @@ cv::Mat DetProcess::letterboxResize(const cv::Mat &img, int target_size, float &
 }
 
 void DetProcess::NHWC3ToNC3HW(const float* src, float* dst, int num_pixels,
-                              const std::vector<float>& mean, const std::vector<float>& scale) {
+                              const float mean[3], const float scale[3]) const {
     for (int i = 0; i < num_pixels; i++) {
         for (int c = 0; c < 3; c++) {
             float value = src[i * 3 + c];
@@ -79,72 +111,418 @@ void DetProcess::NHWC3ToNC3HW(const float* src, float* dst, int num_pixels,
     }
 }
 
-void DetProcess::Preprocess(const cv::Mat &srcimg, int target_size) {
-    letterbox_img_ = letterboxResize(srcimg, target_size, scale_, pad_left_, pad_top_);
-    cv::Mat img_fp;
-    letterbox_img_.convertTo(img_fp, CV_32FC3, 1.0 / 255.f);
+void DetProcess::letterboxInto(const cv::Mat &srcimg, const cv::Size &target, float *dst, LetterboxInfo &info) const {
+    const float mean[3] = {0.485f, 0.456f, 0.406f};
+    const float scale_vec[3] = {1 / 0.229f, 1 / 0.224f, 1 / 0.225f};
     
-    std::unique_ptr<Tensor> input_tensor(std::move(predictor_->GetInput(0)));
-    input_tensor->Resize({1, 3, target_size, target_size});
-    auto *data0 = input_tensor->mutable_data<float>();
+    if (srcimg.type() == CV_8UC3) {
+        // Nhánh nhanh: resize + padding + chuẩn hóa + NCHW trong một lượt, ghi thẳng vào tensor.
+        info.scale = std::min(static_cast<float>(target.width) / srcimg.cols,
+                              static_cast<float>(target.height) / srcimg.rows);
+        // Ảnh rất mảnh: cạnh ngắn không được làm tròn về 0.
+        int new_w = std::max(1, static_cast<int>(srcimg.cols * info.scale));
+        int new_h = std::max(1, static_cast<int>(srcimg.rows * info.scale));
+        info.pad_left = (target.width - new_w) / 2;
+        info.pad_top  = (target.height - new_h) / 2;
+        LetterboxNormalizeNCHW(srcimg, new_w, new_h, target.width, target.height,
+                               info.pad_left, info.pad_top, mean, scale_vec, dst);
+        return;
+    }
     
-    std::vector<float> mean = {0.485f, 0.456f, 0.406f};
-    std::vector<float> scale_vec = {1 / 0.229f, 1 / 0.224f, 1 / 0.225f};
+    // Nhánh cũ cho ảnh không phải BGR uint8.
+    cv::Mat letterbox_img = letterboxResize(srcimg, target.width, target.height, info.scale, info.pad_left, info.pad_top);
+    cv::Mat img_fp;
+    letterbox_img.convertTo(img_fp, CV_32FC3, 1.0 / 255.f);
     const float *dimg = reinterpret_cast<const float *>(img_fp.data);
-    NHWC3ToNC3HW(dimg, data0, target_size * target_size, mean, scale_vec);
+    NHWC3ToNC3HW(dimg, dst, target.width * target.height, mean, scale_vec);
+}
+
+void DetProcess::Preprocess(const cv::Mat &srcimg, const cv::Size &target, PaddlePredictor *predictor,
+                            LetterboxInfo &info) const {
+    std::unique_ptr<Tensor> input_tensor(std::move(predictor->GetInput(0)));
+    input_tensor->Resize({1, 3, target.height, target.width});
+    auto *data0 = input_tensor->mutable_data<float>();
+    letterboxInto(srcimg, target, data0, info);
 }
 
-std::vector<std::vector<std::vector<int>>> DetProcess::Postprocess(const cv::Mat &srcimg,
-                                                                     const std::map<std::string, double> &config,
-                                                                     int det_db_use_dilate) {
-    std::unique_ptr<const Tensor> output_tensor(std::move(predictor_->GetOutput(0)));
+std::vector<Quad> DetProcess::Postprocess(const cv::Mat &srcimg,
+                                          const std::map<std::string, double> &config,
+                                          int det_db_use_dilate,
+                                          PaddlePredictor *predictor,
+                                          const LetterboxInfo &info) const {
+    std::unique_ptr<const Tensor> output_tensor(std::move(predictor->GetOutput(0)));
     auto *outptr = output_tensor->data<float>();
     auto shape = output_tensor->shape();
-    int out_size = shape[2] * shape[3];
-    std::vector<float> pred(out_size);
-    std::vector<unsigned char> cbuf(out_size);
-    for (int i = 0; i < out_size; i++) {
-        pred[i] = outptr[i];
-        cbuf[i] = static_cast<unsigned char>(outptr[i] * 255);
-    }
-    cv::Mat cbuf_map(shape[2], shape[3], CV_8UC1, cbuf.data());
-    cv::Mat pred_map(shape[2], shape[3], CV_32F, pred.data());
-    
-    double threshold = config.at("det_db_thresh") * 255;
-    cv::Mat bit_map;
-    cv::threshold(cbuf_map, bit_map, threshold, 255, cv::THRESH_BINARY);
-    if (det_db_use_dilate == 1) {
-        cv::Mat dilation_map;
-        cv::Mat dila_ele = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2, 2));
-        cv::dilate(bit_map, dilation_map, dila_ele);
-        bit_map = dilation_map;
-    }
-    auto boxes = BoxesFromBitmap(pred_map, bit_map, config);
-    auto filter_boxes = FilterTagDetRes(boxes, scale_, scale_, srcimg);
+    return PostprocessMap(outptr, shape[2], shape[3], srcimg, config, det_db_use_dilate, info);
+}
+
+std::vector<Quad> DetProcess::PostprocessMap(const float *outptr, int map_h, int map_w,
+                                             const cv::Mat &srcimg,
+                                             const std::map<std::string, double> &config,
+                                             int det_db_use_dilate,
+                                             const LetterboxInfo &info) const {
+    // Bọc output tensor thành cv::Mat, không sao chép; BoxesFromBitmap chỉ đọc pred_map.
+    cv::Mat pred_map(map_h, map_w, CV_32F, const_cast<float *>(outptr));
+    
+    // Nhị phân hóa + giãn nở 2x2 trong một lượt SIMD; bit_map dùng lại bộ nhớ giữa các lần gọi trên cùng luồng.
+    thread_local cv::Mat bit_map;
+    ThresholdDilateBitmap(outptr, map_h, map_w, config.at("det_db_thresh"), det_db_use_dilate == 1, bit_map);
+    // Chấm điểm / unclip các ứng viên song song trên pool dùng chung (thứ tự kết quả không đổi).
+    ThreadPool *post_pool = ConfigOr(config, "det_parallel_postprocess", 0) == 1 ? &ThreadPool::Shared() : nullptr;
+    auto boxes = BoxesFromBitmap(pred_map, bit_map, config, post_pool);
+    // Bỏ phần padding của letterbox trước khi chia cho scale để về tọa độ ảnh gốc.
+    for (auto &box : boxes) {
+        for (auto &pt : box.pts) {
+            pt.x -= info.pad_left;
+            pt.y -= info.pad_top;
+        }
+    }
+    auto filter_boxes = FilterTagDetRes(std::move(boxes), info.scale, info.scale, srcimg);
     return filter_boxes;
 }
 
-std::vector<std::vector<std::vector<int>>> DetProcess::detect(const cv::Mat &img, const std::map<std::string, double> &config) {
+cv::Size DetProcess::bucketShape(float ratio, int max_side_len) const {
+    auto align32 = [](float v) { return std::max(32, static_cast<int>(std::ceil(v / 32.f)) * 32); };
+    int side = std::max(32, max_side_len / 32 * 32);
+    if (ratio >= 1.f)
+        return cv::Size(side, std::min(side, align32(side / ratio)));
+    return cv::Size(std::min(side, align32(side * ratio)), side);
+}
+
+cv::Size DetProcess::selectBucket(const cv::Mat &img, int max_side_len) const {
+    cv::Size best(max_side_len, max_side_len);
+    float best_fill = -1.f;
+    float best_scale = 0.f;
+    for (float ratio : bucket_ratios_) {
+        cv::Size shape = bucketShape(ratio, max_side_len);
+        float s = std::min(static_cast<float>(shape.width) / img.cols,
+                           static_cast<float>(shape.height) / img.rows);
+        // Tỷ lệ diện tích bucket thực sự chứa ảnh (phần còn lại là padding).
+        float fill = (img.cols * s) * (img.rows * s) / shape.area();
+        if (fill > best_fill + 1e-3f || (std::fabs(fill - best_fill) <= 1e-3f && s > best_scale)) {
+            best = shape;
+            best_fill = fill;
+            best_scale = s;
+        }
+    }
+    return best;
+}
+
+DetProcess::PredictorLease::PredictorLease(const DetProcess *owner, const ShapeKey &key,
+                                           std::shared_ptr<PaddlePredictor> predictor)
+    : owner_(owner), key_(key), predictor_(std::move(predictor)) {}
+
+DetProcess::PredictorLease::PredictorLease(PredictorLease &&other) noexcept
+    : owner_(other.owner_), key_(other.key_), predictor_(std::move(other.predictor_)) {
+    other.owner_ = nullptr;
+}
+
+DetProcess::PredictorLease::~PredictorLease() {
+    if (!owner_ || !predictor_)
+        return;
+    std::lock_guard<std::mutex> lock(owner_->predictors_mutex_);
+    owner_->idle_predictors_[key_].push_back(std::move(predictor_));
+}
+
+DetProcess::PredictorLease DetProcess::acquirePredictor(const cv::Size &shape, int batch) const {
+    const ShapeKey key = std::make_tuple(batch, shape.width, shape.height);
+    std::lock_guard<std::mutex> lock(predictors_mutex_);
+    auto &idle = idle_predictors_[key];
+    if (idle.empty())
+        return PredictorLease(this, key, predictor_->Clone());
+    std::shared_ptr<PaddlePredictor> predictor = std::move(idle.back());
+    idle.pop_back();
+    return PredictorLease(this, key, std::move(predictor));
+}
+
+void DetProcess::setShapeBuckets(const std::vector<float> &aspect_ratios) {
+    bucket_ratios_.clear();
+    for (float r : aspect_ratios) {
+        if (r > 0.f)
+            bucket_ratios_.push_back(r);
+    }
+    if (bucket_ratios_.empty())
+        bucket_ratios_.push_back(1.f);
+    std::lock_guard<std::mutex> lock(predictors_mutex_);
+    idle_predictors_.clear();
+}
+
+void DetProcess::warmUpBuckets(int max_side_len, int batch) {
+    batch = std::max(1, batch);
+    for (float ratio : bucket_ratios_) {
+        cv::Size shape = bucketShape(ratio, max_side_len);
+        cv::Mat blank = cv::Mat::zeros(shape.height, shape.width, CV_8UC3);
+        PredictorLease predictor = acquirePredictor(shape, batch);
+        std::unique_ptr<Tensor> input_tensor(std::move(predictor->GetInput(0)));
+        input_tensor->Resize({batch, 3, shape.height, shape.width});
+        float *data0 = input_tensor->mutable_data<float>();
+        LetterboxInfo info;
+        for (int i = 0; i < batch; i++)
+            letterboxInto(blank, shape, data0 + static_cast<size_t>(i) * 3 * shape.area(), info);
+        predictor->Run();
+    }
+}
+
+ThreadPool *DetProcess::workerPool(int num_threads) const {
+    num_threads = std::max(1, num_threads);
+    std::lock_guard<std::mutex> lock(pools_mutex_);
+    // Luồng gọi cũng tham gia nên pool chỉ cần num_threads - 1 worker.
+    auto &pool = pools_[num_threads];
+    if (!pool)
+        pool.reset(new ThreadPool(num_threads - 1));
+    return pool.get();
+}
+
+std::vector<Quad> DetProcess::detectTiled(const cv::Mat &img, const std::map<std::string, double> &config,
+                                          DetContext *ctx) const {
+    int max_side_len = static_cast<int>(config.at("max_side_len"));
+    int det_db_use_dilate = static_cast<int>(config.at("det_db_use_dilate"));
+    float tile_scale = static_cast<float>(ConfigOr(config, "det_tile_scale", 1.0));
+    int overlap = static_cast<int>(ConfigOr(config, "det_tile_overlap", 128));
+    int tile_side = static_cast<int>(ConfigOr(config, "det_tile_size", max_side_len));
+    int tile_cols = static_cast<int>(ConfigOr(config, "det_tile_cols", 0));
+    int tile_rows = static_cast<int>(ConfigOr(config, "det_tile_rows", 0));
+    int threads = static_cast<int>(ConfigOr(config, "det_tile_threads", 2));
+    float merge_iou = static_cast<float>(ConfigOr(config, "det_tile_merge_iou", 0.3));
+    
+    cv::Mat scaled = img;
+    if (tile_scale > 0.f && std::fabs(tile_scale - 1.f) > 1e-3f)
+        cv::resize(img, scaled, cv::Size(), tile_scale, tile_scale, cv::INTER_AREA);
+    else
+        tile_scale = 1.f;
+    
+    int tile_w = tile_cols > 0 ? TileSideForCount(scaled.cols, tile_cols, overlap) : tile_side;
+    int tile_h = tile_rows > 0 ? TileSideForCount(scaled.rows, tile_rows, overlap) : tile_side;
+    std::vector<cv::Rect> tiles = PlanTiles(scaled.size(), tile_w, tile_h, overlap);
+    
+    ThreadPool *pool = workerPool(threads);
+    std::vector<std::vector<Quad>> tile_boxes(tiles.size());
+    pool->parallelFor(static_cast<int>(tiles.size()), [&](int i, int) {
+        cv::Mat tile = scaled(tiles[i]);
+        // Tile có cùng kích thước nên shape tensor cố định, chỉ làm tròn lên bội số của 32.
+        cv::Size target((tile.cols + 31) / 32 * 32, (tile.rows + 31) / 32 * 32);
+        PredictorLease predictor = acquirePredictor(target);
+        LetterboxInfo info;
+        Preprocess(tile, target, predictor.get(), info);
+        predictor->Run();
+        tile_boxes[i] = Postprocess(tile, config, det_db_use_dilate, predictor.get(), info);
+    });
+    
+    // Đưa box về tọa độ ảnh gốc rồi gộp các box bị cắt ở vùng nối.
+    std::vector<Quad> boxes;
+    std::vector<int> tile_ids;
+    for (size_t t = 0; t < tiles.size(); t++) {
+        for (auto &box : tile_boxes[t]) {
+            for (auto &pt : box.pts) {
+                pt.x = static_cast<float>(std::min(static_cast<int>((pt.x + tiles[t].x) / tile_scale), img.cols - 1));
+                pt.y = static_cast<float>(std::min(static_cast<int>((pt.y + tiles[t].y) / tile_scale), img.rows - 1));
+            }
+            boxes.push_back(box);
+            tile_ids.push_back(static_cast<int>(t));
+        }
+    }
+    if (ctx) {
+        ctx->letterbox = LetterboxInfo{tile_scale, 0, 0};
+        ctx->input_shape = cv::Size();
+    }
+    return MergeTileBoxes(boxes, tile_ids, merge_iou);
+}
+
+std::vector<Quad> DetProcess::detectCoarseToFine(const cv::Mat &img, const std::map<std::string, double> &config,
+                                                 DetContext *ctx) const {
+    int max_side_len = static_cast<int>(config.at("max_side_len"));
+    int det_db_use_dilate = static_cast<int>(config.at("det_db_use_dilate"));
+    int coarse_side = static_cast<int>(ConfigOr(config, "det_coarse_side_len", 320)) / 32 * 32;
+    float coarse_thresh = static_cast<float>(ConfigOr(config, "det_coarse_thresh", 0.3));
+    int roi_margin = static_cast<int>(ConfigOr(config, "det_roi_margin", 16));
+    double roi_max_ratio = ConfigOr(config, "det_roi_max_ratio", 0.6);
+    coarse_side = std::max(32, coarse_side);
+    
+    // Lượt thô: bản đồ xác suất ở độ phân giải thấp.
+    cv::Size coarse_target(coarse_side, coarse_side);
+    PredictorLease coarse_predictor = acquirePredictor(coarse_target);
+    LetterboxInfo coarse_info;
+    Preprocess(img, coarse_target, coarse_predictor.get(), coarse_info);
+    coarse_predictor->Run();
+    
+    std::unique_ptr<const Tensor> coarse_out(std::move(coarse_predictor->GetOutput(0)));
+    const float *prob = coarse_out->data<float>();
+    auto shape = coarse_out->shape();
+    cv::Mat mask(static_cast<int>(shape[2]), static_cast<int>(shape[3]), CV_8UC1);
+    for (int y = 0; y < mask.rows; y++) {
+        const float *p = prob + static_cast<size_t>(y) * mask.cols;
+        unsigned char *m = mask.ptr<unsigned char>(y);
+        for (int x = 0; x < mask.cols; x++)
+            m[x] = p[x] > coarse_thresh ? 255 : 0;
+    }
+    cv::dilate(mask, mask, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3)));
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    
+    // Đưa vùng chữ về tọa độ ảnh gốc, nới rộng và gộp các vùng chạm nhau.
+    const cv::Rect image_rect(0, 0, img.cols, img.rows);
+    std::vector<cv::Rect> rois;
+    for (const auto &contour : contours) {
+        cv::Rect r = cv::boundingRect(contour);
+        int x0 = static_cast<int>((r.x - coarse_info.pad_left) / coarse_info.scale) - roi_margin;
+        int y0 = static_cast<int>((r.y - coarse_info.pad_top) / coarse_info.scale) - roi_margin;
+        int x1 = static_cast<int>(std::ceil((r.x + r.width - coarse_info.pad_left) / coarse_info.scale)) + roi_margin;
+        int y1 = static_cast<int>(std::ceil((r.y + r.height - coarse_info.pad_top) / coarse_info.scale)) + roi_margin;
+        cv::Rect roi = cv::Rect(x0, y0, x1 - x0, y1 - y0) & image_rect;
+        if (roi.area() > 0)
+            rois.push_back(roi);
+    }
+    rois = MergeOverlappingRects(rois, 0);
+    if (rois.empty()) {
+        if (ctx)
+            *ctx = DetContext();
+        return {};
+    }
+    
+    double roi_area = 0.0;
+    for (const auto &roi : rois)
+        roi_area += roi.area();
+    if (roi_area > roi_max_ratio * image_rect.area()) {
+        // ROI phủ gần hết ảnh: một lượt toàn khung rẻ hơn nhiều lượt nhỏ.
+        std::map<std::string, double> full_config = config;
+        full_config["det_use_coarse_to_fine"] = 0;
+        return detect(img, full_config, ctx);
+    }
+    
+    // Lượt tinh: mỗi ROI được detect với cạnh dài tới max_side_len (không phóng to quá độ phân giải gốc),
+    // nên chữ nhỏ có nhiều điểm ảnh hơn hẳn lượt toàn khung. Shape input là bucket tỷ lệ khung hình
+    // (selectBucket) với cạnh dài lấy từ một tập cố định, nên các ROI dùng lại predictor đã có.
+    std::vector<Quad> boxes;
+    std::vector<int> roi_ids;
+    float min_scale = 1.f;
+    for (size_t r = 0; r < rois.size(); r++) {
+        cv::Mat roi_img = img(rois[r]);
+        const cv::Size target = selectBucket(roi_img, FineSideLength(std::max(roi_img.cols, roi_img.rows), max_side_len));
+        PredictorLease fine_predictor = acquirePredictor(target);
+        LetterboxInfo info;
+        Preprocess(roi_img, target, fine_predictor.get(), info);
+        fine_predictor->Run();
+        min_scale = std::min(min_scale, info.scale);
+        auto roi_boxes = Postprocess(roi_img, config, det_db_use_dilate, fine_predictor.get(), info);
+        for (auto &box : roi_boxes) {
+            for (auto &pt : box.pts) {
+                pt.x += rois[r].x;
+                pt.y += rois[r].y;
+            }
+            boxes.push_back(box);
+            roi_ids.push_back(static_cast<int>(r));
+        }
+    }
+    if (ctx) {
+        ctx->letterbox = LetterboxInfo{min_scale, 0, 0};
+        ctx->input_shape = cv::Size();
+    }
+    float merge_iou = static_cast<float>(ConfigOr(config, "det_tile_merge_iou", 0.3));
+    return MergeTileBoxes(boxes, roi_ids, merge_iou);
+}
+
+std::vector<std::vector<Quad>>
+DetProcess::detectBatch(const std::vector<cv::Mat> &imgs, const std::map<std::string, double> &config) const {
+    std::vector<std::vector<Quad>> results(imgs.size());
+    // Tile và coarse-to-fine có shape riêng cho từng ảnh (từng tile / ROI), không gộp lô được.
+    if (static_cast<int>(ConfigOr(config, "det_use_tiles", 0)) == 1 ||
+        static_cast<int>(ConfigOr(config, "det_use_coarse_to_fine", 0)) == 1) {
+        for (size_t i = 0; i < imgs.size(); i++)
+            results[i] = detect(imgs[i], config);
+        return results;
+    }
+    int max_side_len = static_cast<int>(config.at("max_side_len"));
+    int det_db_use_dilate = static_cast<int>(config.at("det_db_use_dilate"));
+    int batch_size = std::max(1, static_cast<int>(ConfigOr(config, "det_batch_size", 4)));
+    int threads = static_cast<int>(ConfigOr(config, "det_batch_threads", 2));
+    const bool use_buckets = static_cast<int>(ConfigOr(config, "det_use_shape_buckets", 0)) == 1;
+    ThreadPool *pool = workerPool(threads);
+    
+    // Gom ảnh theo shape input (bucket tỷ lệ như detect, hoặc khung vuông), giữ thứ tự trong mỗi nhóm.
+    std::map<std::pair<int, int>, std::vector<size_t>> groups;
+    for (size_t i = 0; i < imgs.size(); i++) {
+        cv::Size target = use_buckets ? selectBucket(imgs[i], max_side_len) : cv::Size(max_side_len, max_side_len);
+        groups[std::make_pair(target.width, target.height)].push_back(i);
+    }
+    
+    std::vector<LetterboxInfo> infos(imgs.size());
+    for (const auto &group : groups) {
+        const cv::Size target(group.first.first, group.first.second);
+        const std::vector<size_t> &members = group.second;
+        const size_t image_size = static_cast<size_t>(3) * target.area();
+        for (size_t begin = 0; begin < members.size(); begin += batch_size) {
+            int n = static_cast<int>(std::min(members.size() - begin, static_cast<size_t>(batch_size)));
+            PredictorLease predictor = acquirePredictor(target, n);
+            
+            // Letterbox n ảnh vào n lát liên tiếp của cùng một tensor {n, 3, H, W}.
+            std::unique_ptr<Tensor> input_tensor(std::move(predictor->GetInput(0)));
+            input_tensor->Resize({n, 3, target.height, target.width});
+            float *data0 = input_tensor->mutable_data<float>();
+            pool->parallelFor(n, [&](int i, int) {
+                const size_t index = members[begin + i];
+                letterboxInto(imgs[index], target, data0 + i * image_size, infos[index]);
+            });
+            
+            predictor->Run();
+            
+            // Output có shape {n, 1, H, W}: tách từng bản đồ xác suất và hậu xử lý song song.
+            std::unique_ptr<const Tensor> output_tensor(std::move(predictor->GetOutput(0)));
+            const float *outptr = output_tensor->data<float>();
+            auto shape = output_tensor->shape();
+            const int map_h = static_cast<int>(shape[2]);
+            const int map_w = static_cast<int>(shape[3]);
+            const size_t map_size = static_cast<size_t>(map_h) * map_w;
+            pool->parallelFor(n, [&](int i, int) {
+                const size_t index = members[begin + i];
+                results[index] = PostprocessMap(outptr + i * map_size, map_h, map_w, imgs[index],
+                                                config, det_db_use_dilate, infos[index]);
+            });
+        }
+    }
+    return results;
+}
+
+std::vector<Quad> DetProcess::detect(const cv::Mat &img, const std::map<std::string, double> &config,
+                                     DetContext *ctx) const {
+    if (static_cast<int>(ConfigOr(config, "det_use_tiles", 0)) == 1)
+        return detectTiled(img, config, ctx);
+    if (static_cast<int>(ConfigOr(config, "det_use_coarse_to_fine", 0)) == 1)
+        return detectCoarseToFine(img, config, ctx);
+    
     cv::Mat srcimg;
     img.copyTo(srcimg);
-    int target_size = static_cast<int>(config.at("max_side_len")); // target_size = 640
+    int max_side_len = static_cast<int>(config.at("max_side_len")); // max_side_len = 640
     int det_db_use_dilate = static_cast<int>(config.at("det_db_use_dilate"));
     
-    Preprocess(img, target_size);
-    predictor_->Run();
-    auto boxes = Postprocess(srcimg, config, det_db_use_dilate);
+    cv::Size target(max_side_len, max_side_len);
+    if (static_cast<int>(ConfigOr(config, "det_use_shape_buckets", 0)) == 1)
+        target = selectBucket(img, max_side_len);
+    
+    PredictorLease predictor = acquirePredictor(target);
+    LetterboxInfo info;
+    Preprocess(img, target, predictor.get(), info);
+    predictor->Run();
+    auto boxes = Postprocess(srcimg, config, det_db_use_dilate, predictor.get(), info);
+    if (ctx) {
+        ctx->letterbox = info;
+        ctx->input_shape = target;
+    }
     return boxes;
 }
 
-float DetProcess::getScale() const { return scale_; }
-int DetProcess::getPadLeft() const { return pad_left_; }
-int DetProcess::getPadTop() const { return pad_top_; }
+std::vector<std::vector<std::vector<int>>> DetProcess::detectBoxes(const cv::Mat &img,
+                                                                    const std::map<std::string, double> &config) const {
+    return QuadsToBoxes(detect(img, config));
+}
 
 } // namespace ocr
 
 // ---------------- Main Function (Detection + Recognition Pipeline) ----------------
 
-#include "rec_process.h" // Sử dụng lớp RecProcess để nhận dạng
+#include "image_loader.h"
+#include "rec_pool.h" // Sử dụng RecPool (các RecProcess clone) để nhận dạng song song
+#include "text_crop.h"
+#include <sys/resource.h>
 
 int main() {
     using namespace ocr;
@@ -167,57 +545,149 @@ int main() {
     detConfig["det_db_thresh"] = 0.8;         // Ngưỡng detection.
     detConfig["det_db_unclip_ratio"] = 1.0;
     detConfig["det_db_use_dilate"] = 1;
+    detConfig["det_parallel_postprocess"] = 1; // Chấm điểm / unclip box song song trên pool dùng chung.
+    detConfig["det_box_extractor"] = 0;       // 0: findContours, 1: connected components (BoxesFromComponents).
+    detConfig["det_use_shape_buckets"] = 1;   // Chọn bucket tỷ lệ khung hình thay vì khung vuông.
+    detConfig["det_use_tiles"] = 0;           // Bật cho ảnh scan rất lớn (xem DetProcess::detectTiled).
+    detConfig["det_tile_overlap"] = 128;
+    detConfig["det_tile_threads"] = 2;
+    detConfig["det_use_coarse_to_fine"] = 0;  // Lượt thô 320 rồi chỉ detect lại các vùng có chữ.
+    detConfig["det_coarse_side_len"] = 320;
+    detConfig["det_batch_size"] = 4;          // Số ảnh mỗi lần Run() khi xử lý cả thư mục (1, 2, 4, 8,...).
+    detConfig["det_batch_threads"] = 2;
+    // Box thấp hơn ngưỡng này (pixel) trên ảnh thu nhỏ được crop từ ảnh decode lại ở mức thu nhỏ vừa đủ.
+    detConfig["rec_min_crop_height"] = kDefaultMinCropHeight;
+    
+    // Cấu hình cho recognition.
+    std::map<std::string, double> recConfig;
+    recConfig["rec_batch_size"] = 8;          // Số dòng tối đa mỗi lần Run() (cùng bucket chiều rộng).
+    recConfig["rec_pool_size"] = 4;           // Số predictor recognition chạy song song (clone dùng chung trọng số).
+    recConfig["rec_threads_per_predictor"] = 1;
     
     int cpu_threads = 4;
     std::string cpu_power_mode = "LITE_POWER_HIGH";
     
     // Khởi tạo module detection và recognition.
     DetProcess detector(det_model_path, cpu_threads, cpu_power_mode);
-    RecProcess recognizer(rec_model_path, char_dict_path);
+    RecPool recognizer(rec_model_path, char_dict_path, static_cast<int>(recConfig["rec_pool_size"]),
+                       static_cast<int>(recConfig["rec_threads_per_predictor"]));
+    // Xử lý theo lô det_batch_size ảnh (detectBatch); det_batch_size = 1 hoặc chế độ tile thì detect từng ảnh.
+    const size_t batch_size = static_cast<size_t>(std::max(1.0, detConfig["det_batch_size"]));
+    const bool use_batch = batch_size > 1 && detConfig["det_use_tiles"] != 1;
+    // Lô đầy của detectBatch dùng predictor (det_batch_size, bucket), detect từng ảnh dùng (1, bucket).
+    if (detConfig["det_use_shape_buckets"] == 1 && detConfig["det_use_coarse_to_fine"] != 1)
+        detector.warmUpBuckets(static_cast<int>(detConfig["max_side_len"]), use_batch ? static_cast<int>(batch_size) : 1);
+    // Chạy trước shape của các lô đầy (mỗi bucket chiều rộng) để lần nhận dạng đầu tiên không phải lập kế
+    // hoạch bộ nhớ.
+    recognizer.warmUp(static_cast<int>(recConfig["rec_batch_size"]));
     
-    // Duyệt qua các ảnh trong thư mục input.
+    // Thu thập danh sách ảnh trong thư mục input.
+    std::vector<std::filesystem::path> image_paths;
     for (const auto &entry : std::filesystem::directory_iterator(input_dir)) {
         if (!entry.is_regular_file()) continue;
-        std::string file_path = entry.path().string();
         std::string ext = entry.path().extension().string();
         std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
         if (ext != ".jpg" && ext != ".jpeg" && ext != ".png") continue;
-        
-        cv::Mat image = cv::imread(file_path);
-        if (image.empty()) {
-            std::cerr << "Không thể tải ảnh: " << file_path << std::endl;
-            continue;
+        image_paths.push_back(entry.path());
+    }
+    
+    double total_det_ms = 0.0;
+    double total_decode_ms = 0.0;
+    double total_rec_ms = 0.0;
+    size_t total_lines = 0;
+    size_t total_images = 0;
+    // Decode JPEG thu nhỏ 1/2, 1/4, 1/8 nhưng cạnh dài vẫn >= max_side_len (tắt khi chạy tile ở độ phân giải gốc).
+    const int decode_min_side = detConfig["det_use_tiles"] == 1 ? 0 : static_cast<int>(detConfig["max_side_len"]);
+    const int rec_min_crop_height = static_cast<int>(detConfig["rec_min_crop_height"]);
+    for (size_t begin = 0; begin < image_paths.size(); begin += batch_size) {
+        std::vector<std::filesystem::path> paths;
+        std::vector<DecodedImage> decoded;
+        std::vector<cv::Mat> images;
+        for (size_t i = begin; i < std::min(begin + batch_size, image_paths.size()); i++) {
+            auto decode_start = std::chrono::steady_clock::now();
+            DecodedImage loaded = LoadImageForDetection(image_paths[i].string(), decode_min_side);
+            total_decode_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decode_start).count();
+            if (loaded.image.empty()) {
+                std::cerr << "Không thể tải ảnh: " << image_paths[i].string() << std::endl;
+                continue;
+            }
+            paths.push_back(image_paths[i]);
+            images.push_back(loaded.image);
+            decoded.push_back(std::move(loaded));
         }
+        if (images.empty()) continue;
         
-        // Chạy detection.
-        auto boxes = detector.detect(image, detConfig);
+        // Chạy detection và đo thời gian cho cả lô.
+        auto det_start = std::chrono::steady_clock::now();
+        std::vector<std::vector<Quad>> batch_boxes;
+        if (use_batch) {
+            batch_boxes = detector.detectBatch(images, detConfig);
+        } else {
+            for (const auto &image : images)
+                batch_boxes.push_back(detector.detect(image, detConfig));
+        }
+        double det_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - det_start).count();
+        total_det_ms += det_ms;
+        total_images += images.size();
         
-        // Vẽ các box lên ảnh gốc.
-        for (const auto &box : boxes) {
-            std::vector<cv::Point> pts;
-            for (const auto &pt : box) {
-                pts.push_back(cv::Point(pt[0], pt[1]));
+        for (size_t k = 0; k < images.size(); k++) {
+            cv::Mat &image = images[k];
+            const auto &boxes = batch_boxes[k];
+            std::string file_name = paths[k].filename().string();
+            std::cout << "Ảnh " << file_name << " (" << image.cols << "x" << image.rows
+                      << ") -> detect: " << det_ms / images.size() << " ms/ảnh, " << boxes.size() << " box" << std::endl;
+            
+            // Gom các box đủ lớn của ảnh rồi nhận dạng theo lô (crop trước khi vẽ box lên ảnh).
+            PrepareRecognitionSource(decoded[k], boxes, rec_min_crop_height);
+            std::vector<RecCrop> crops;
+            for (const auto &box : boxes) {
+                Quad src_box;
+                const cv::Mat &source = SourceForRecognition(decoded[k], box, rec_min_crop_height, src_box);
+                // Loại bỏ box quá nhỏ.
+                if (CropSize(src_box).area() < 100)
+                    continue;
+                crops.emplace_back(source, src_box);
+            }
+            auto rec_start = std::chrono::steady_clock::now();
+            std::vector<DecodeResult> rec_results = recognizer.recognizeAll(crops, recConfig);
+            double rec_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - rec_start).count();
+            total_rec_ms += rec_ms;
+            total_lines += crops.size();
+            for (const auto &rec_result : rec_results) {
+                std::cout << "Ảnh " << file_name
+                          << " -> text: " << rec_result.text 
+                          << " (confidence: " << rec_result.confidence << ")" << std::endl;
             }
-            if (pts.size() >= 4)
+            std::cout << "Ảnh " << file_name << " -> recognize: " << rec_ms << " ms, " << crops.size() << " dòng" << std::endl;
+            
+            // Vẽ các box lên ảnh.
+            for (const auto &box : boxes) {
+                std::vector<cv::Point> pts;
+                for (const auto &pt : box.pts) {
+                    pts.push_back(cv::Point(static_cast<int>(pt.x), static_cast<int>(pt.y)));
+                }
                 cv::polylines(image, pts, true, cv::Scalar(0, 0, 255), 2);
+            }
+            
+            // Lưu ảnh đã có box vào thư mục output.
+            std::string output_path = output_dir + "/" + file_name;
+            cv::imwrite(output_path, image);
         }
-        
-        // Lưu ảnh đã có box vào thư mục output.
-        std::string output_path = output_dir + "/" + entry.path().filename().string();
-        cv::imwrite(output_path, image);
-        
-        // Với mỗi box, crop vùng chữ và chạy recognition.
-        for (const auto &box : boxes) {
-            cv::Mat crop = CropBox(image, box);
-            // Loại bỏ box quá nhỏ.
-            if (cv::boundingRect(crop).area() < 100)
-                continue;
-            DecodeResult rec_result = recognizer.recognize(crop);
-            std::cout << "Ảnh " << entry.path().filename().string() 
-                      << " -> text: " << rec_result.text 
-                      << " (confidence: " << rec_result.confidence << ")" << std::endl;
-        }
     }
+    if (total_images > 0) {
+        std::cout << "Detection: " << total_images << " ảnh, batch " << (use_batch ? batch_size : 1)
+                  << ", " << total_images * 1000.0 / total_det_ms << " ảnh/s" << std::endl;
+        std::cout << "Decode: " << total_decode_ms / total_images << " ms/ảnh (decode_min_side = "
+                  << decode_min_side << ")" << std::endl;
+    }
+    if (total_lines > 0) {
+        std::cout << "Recognition: " << total_lines << " dòng, batch " << recConfig["rec_batch_size"]
+                  << ", " << recognizer.size() << " predictor x " << recConfig["rec_threads_per_predictor"] << " luồng"
+                  << ", " << total_lines * 1000.0 / total_rec_ms << " dòng/s" << std::endl;
+    }
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        std::cout << "Peak RSS: " << usage.ru_maxrss / 1024 << " MB" << std::endl;
     
     return 0;
 }
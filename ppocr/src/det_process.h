@@ -2,50 +2,175 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
 #include "opencv2/core.hpp"
 #include "paddle_api.h"
+#include "quad.h"
 
 namespace ocr {
 
+class ThreadPool;
+
+// Crop vùng chữ từ ảnh dựa vào 4 điểm (box) thông qua biến đổi perspective.
+cv::Mat CropBox(const cv::Mat &src, const Quad &box);
+// Adapter cho box dạng cũ (vector 4 điểm [x, y]).
+cv::Mat CropBox(const cv::Mat &src, const std::vector<std::vector<int>> &box);
+
+// Thông số letterbox của một lần tiền xử lý, dùng để đưa box về tọa độ ảnh đầu vào.
+struct LetterboxInfo {
+    float scale = 1.f;
+    int pad_left = 0;
+    int pad_top = 0;
+};
+
+// Trạng thái của một lần detect, do người gọi giữ (DetProcess không lưu gì theo lần gọi).
+struct DetContext {
+    // Letterbox của lượt detect chính; với detectTiled / detectCoarseToFine, scale là hệ số
+    // ảnh gốc -> ảnh được detect (nhỏ nhất trong các ROI của detectCoarseToFine) và pad bằng 0.
+    LetterboxInfo letterbox;
+    // Shape input (w x h) của lượt detect chính (0x0 với detectTiled / detectCoarseToFine).
+    cv::Size input_shape;
+};
+
+// Detector dùng chung được giữa nhiều luồng: các hàm detect* là const, mọi trạng thái của một lần gọi
+// nằm trong biến cục bộ / DetContext, còn predictor được mượn từ pool theo shape (mỗi lần Run() dùng
+// một bản clone riêng, chung trọng số với mô hình đã load). setShapeBuckets / warmUpBuckets chỉ gọi
+// lúc khởi tạo, trước khi chia sẻ detector.
 class DetProcess {
 public:
     // Khởi tạo với đường dẫn mô hình, số luồng CPU và chế độ năng lượng (ví dụ: "LITE_POWER_HIGH")
     DetProcess(const std::string &model_path, int cpu_threads, const std::string &cpu_power_mode);
+    ~DetProcess();
 
     // Hàm detect: chạy detection trên ảnh đầu vào với cấu hình config.
-    // Trả về vector chứa các box (mỗi box là vector gồm 4 điểm [x, y] theo tọa độ ảnh gốc).
-    std::vector<std::vector<std::vector<int>>> detect(const cv::Mat &img, const std::map<std::string, double> &config);
+    // Trả về các Quad (4 điểm tl, tr, br, bl theo tọa độ ảnh gốc, kèm score và góc).
+    // Nếu config["det_use_shape_buckets"] = 1, ảnh được letterbox vào bucket tỷ lệ gần nhất
+    // (bội số của 32, cạnh dài = max_side_len) thay vì khung vuông max_side_len x max_side_len.
+    // Nếu config["det_use_tiles"] = 1, chuyển sang detectTiled; nếu config["det_use_coarse_to_fine"] = 1,
+    // chuyển sang detectCoarseToFine.
+    // ctx (nếu khác nullptr) nhận thông số letterbox của lần gọi này.
+    std::vector<Quad> detect(const cv::Mat &img, const std::map<std::string, double> &config,
+                             DetContext *ctx = nullptr) const;
+
+    // Adapter cho API cũ: như detect nhưng trả về box dạng vector 4 điểm [x, y].
+    std::vector<std::vector<std::vector<int>>> detectBoxes(const cv::Mat &img,
+                                                            const std::map<std::string, double> &config) const;
+
+    // Detection theo tile cho ảnh rất lớn: ảnh (sau khi nhân det_tile_scale, mặc định 1 = độ phân giải gốc)
+    // được chia thành các tile chồng lấn, các tile chạy song song trên predictor clone,
+    // sau đó box ở vùng nối được gộp lại theo IoU và tính thẳng hàng (MergeTileBoxes).
+    // Các khóa config tùy chọn:
+    //   det_tile_size     cạnh tile (mặc định max_side_len)
+    //   det_tile_cols / det_tile_rows  số tile mỗi chiều (nếu > 0 sẽ thay cho det_tile_size)
+    //   det_tile_overlap  số pixel chồng lấn giữa hai tile (mặc định 128)
+    //   det_tile_scale    hệ số scale ảnh trước khi chia tile (mặc định 1.0)
+    //   det_tile_threads  số luồng chạy tile song song (mặc định 2)
+    //   det_tile_merge_iou  ngưỡng IoU để gộp box trùng (mặc định 0.3)
+    std::vector<Quad> detectTiled(const cv::Mat &img, const std::map<std::string, double> &config,
+                                  DetContext *ctx = nullptr) const;
 
-    // Accessors cho các thông số chuyển đổi (nếu cần cho recognition sau này)
-    float getScale() const;
-    int getPadLeft() const;
-    int getPadTop() const;
+    // Detection hai lượt cho ảnh thưa chữ: lượt thô ở độ phân giải thấp (det_coarse_side_len, mặc định 320)
+    // cho bản đồ xác suất, các vùng chữ (ngưỡng det_coarse_thresh, mặc định 0.3) được nới rộng
+    // det_roi_margin pixel ảnh gốc (mặc định 16) và gộp thành các ROI. Mỗi ROI được detect lại với cạnh dài
+    // tới max_side_len (không phóng to quá độ phân giải gốc) trong một bucket tỷ lệ khung hình, box được đưa
+    // về tọa độ ảnh gốc và khử trùng lặp.
+    // Nếu tổng diện tích ROI vượt det_roi_max_ratio (mặc định 0.6) diện tích ảnh thì chạy một lượt toàn khung.
+    std::vector<Quad> detectCoarseToFine(const cv::Mat &img, const std::map<std::string, double> &config,
+                                         DetContext *ctx = nullptr) const;
+
+    // Detection theo lô cho xử lý hàng loạt: ảnh được gom theo shape input như detect (bucket tỷ lệ của
+    // selectBucket nếu config["det_use_shape_buckets"] = 1, ngược lại khung vuông max_side_len x max_side_len);
+    // mỗi lô tối đa config["det_batch_size"] ảnh (mặc định 4) cùng shape được letterbox vào cùng một tensor
+    // {N, 3, H, W}, chạy predictor một lần, rồi tách N bản đồ xác suất và hậu xử lý song song
+    // (config["det_batch_threads"], mặc định 2). Với det_use_tiles hoặc det_use_coarse_to_fine = 1, mỗi ảnh
+    // được detect riêng (detect) vì shape của các lượt phụ thuộc từng ảnh.
+    // Kết quả trả về theo đúng thứ tự ảnh đầu vào.
+    std::vector<std::vector<Quad>>
+    detectBatch(const std::vector<cv::Mat> &imgs, const std::map<std::string, double> &config) const;
+
+    // Thiết lập tập bucket tỷ lệ khung hình (rộng / cao) dùng cho chế độ det_use_shape_buckets.
+    void setShapeBuckets(const std::vector<float> &aspect_ratios);
+
+    // Chạy trước mỗi bucket một lần với max_side_len cho trước để các predictor
+    // đã được lập kế hoạch bộ nhớ trước khi xử lý ảnh thật. batch: số ảnh mỗi lần Run() (1 cho detect,
+    // det_batch_size cho lô đầy của detectBatch; lô cuối nhỏ hơn tạo predictor khi gặp lần đầu).
+    void warmUpBuckets(int max_side_len, int batch = 1);
 
 private:
-    // Hàm letterbox resize: đưa ảnh về kích thước target_size x target_size (640×640),
+    using ShapeKey = std::tuple<int, int, int>; // (batch, w, h); (batch, 0, 0) = shape thay đổi theo lần gọi
+
+    // Quyền dùng riêng một predictor của pool, tự trả về pool khi bị hủy.
+    class PredictorLease {
+    public:
+        PredictorLease(const DetProcess *owner, const ShapeKey &key,
+                       std::shared_ptr<paddle::lite_api::PaddlePredictor> predictor);
+        PredictorLease(PredictorLease &&other) noexcept;
+        ~PredictorLease();
+        PredictorLease(const PredictorLease &) = delete;
+        PredictorLease &operator=(const PredictorLease &) = delete;
+        PredictorLease &operator=(PredictorLease &&) = delete;
+
+        paddle::lite_api::PaddlePredictor *get() const { return predictor_.get(); }
+        paddle::lite_api::PaddlePredictor *operator->() const { return predictor_.get(); }
+
+    private:
+        const DetProcess *owner_;
+        ShapeKey key_;
+        std::shared_ptr<paddle::lite_api::PaddlePredictor> predictor_;
+    };
+
+    // Hàm letterbox resize: đưa ảnh về kích thước target_w x target_h,
     // giữ tỷ lệ ban đầu và bổ sung padding đều.
-    cv::Mat letterboxResize(const cv::Mat &img, int target_size, float &scale, int &pad_left, int &pad_top);
+    cv::Mat letterboxResize(const cv::Mat &img, int target_w, int target_h, float &scale, int &pad_left, int &pad_top) const;
 
     // Hàm chuyển đổi dữ liệu ảnh từ định dạng NHWC sang NCHW và chuẩn hóa.
     void NHWC3ToNC3HW(const float* src, float* dst, int num_pixels,
-                      const std::vector<float>& mean, const std::vector<float>& scale);
+                      const float mean[3], const float scale[3]) const;
 
-    // Tiến trình tiền xử lý: resize ảnh và chuẩn bị tensor cho mô hình.
-    void Preprocess(const cv::Mat &srcimg, int target_size);
+    // Tiến trình tiền xử lý: resize ảnh và chuẩn bị tensor input của predictor theo kích thước target.
+    // Ảnh BGR uint8 đi qua kernel gộp LetterboxNormalizeNCHW (simd_kernels.h),
+    // các định dạng khác dùng letterboxResize + NHWC3ToNC3HW.
+    void Preprocess(const cv::Mat &srcimg, const cv::Size &target,
+                    paddle::lite_api::PaddlePredictor *predictor, LetterboxInfo &info) const;
+    // Letterbox + chuẩn hóa một ảnh vào vùng dst (3 x target.height x target.width float).
+    void letterboxInto(const cv::Mat &srcimg, const cv::Size &target, float *dst, LetterboxInfo &info) const;
 
     // Hậu xử lý: lấy output của mô hình, xử lý bit_map và chuyển tọa độ về ảnh gốc.
-    std::vector<std::vector<std::vector<int>>> Postprocess(const cv::Mat &srcimg,
-                                                             const std::map<std::string, double> &config,
-                                                             int det_db_use_dilate);
+    std::vector<Quad> Postprocess(const cv::Mat &srcimg,
+                                  const std::map<std::string, double> &config,
+                                  int det_db_use_dilate,
+                                  paddle::lite_api::PaddlePredictor *predictor,
+                                  const LetterboxInfo &info) const;
+    // Hậu xử lý trên một bản đồ xác suất map_h x map_w (một lát của output tensor).
+    std::vector<Quad> PostprocessMap(const float *outptr, int map_h, int map_w,
+                                     const cv::Mat &srcimg,
+                                     const std::map<std::string, double> &config,
+                                     int det_db_use_dilate,
+                                     const LetterboxInfo &info) const;
+
+    // Kích thước (bội số của 32) của bucket có tỷ lệ ratio, cạnh dài bằng max_side_len.
+    cv::Size bucketShape(float ratio, int max_side_len) const;
+    // Chọn bucket ít padding nhất cho ảnh (ưu tiên bucket giữ độ phân giải cao hơn).
+    cv::Size selectBucket(const cv::Mat &img, int max_side_len) const;
+    // Mượn một predictor rảnh cho shape (batch, w, h), clone từ predictor_ nếu chưa có.
+    // shape rỗng: predictor cho các lượt có shape thay đổi theo từng lần gọi.
+    PredictorLease acquirePredictor(const cv::Size &shape, int batch = 1) const;
+    // Pool luồng cho tile / batch theo số luồng, tạo ở lần đầu và giữ đến khi hủy detector.
+    ThreadPool *workerPool(int num_threads) const;
 
-    // Predictor của Paddle Lite.
+    // Predictor của Paddle Lite đã load mô hình; chỉ dùng làm bản gốc để clone, không chạy trực tiếp.
     std::shared_ptr<paddle::lite_api::PaddlePredictor> predictor_;
-    // Ảnh sau letterbox resize (640×640)
-    cv::Mat letterbox_img_;
-    // Các thông số dùng để chuyển tọa độ từ không gian letterbox về ảnh gốc.
-    float scale_ = 1.f;
-    int pad_left_ = 0;
-    int pad_top_ = 0;
+    // Tỷ lệ rộng / cao của các bucket.
+    std::vector<float> bucket_ratios_ = {1.f / 3, 1.f / 2, 3.f / 4, 1.f, 4.f / 3, 16.f / 9, 3.f};
+    // Predictor rảnh theo shape: mỗi shape có các bản clone riêng để không phải lập lại kế hoạch bộ nhớ
+    // khi đổi shape, và đủ bản clone cho số luồng đang detect cùng shape đó.
+    mutable std::map<ShapeKey, std::vector<std::shared_ptr<paddle::lite_api::PaddlePredictor>>> idle_predictors_;
+    mutable std::mutex predictors_mutex_;
+    // Pool luồng cho tile / batch theo số luồng.
+    mutable std::map<int, std::unique_ptr<ThreadPool>> pools_;
+    mutable std::mutex pools_mutex_;
 };
 
 } // namespace ocr
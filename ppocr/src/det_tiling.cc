@@ -0,0 +1,230 @@
+#include "det_tiling.h"
+#include "db_post_process.h"  // OrderPointsClockwise
+#include "opencv2/imgproc.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace ocr {
+
+namespace {
+
+// Vị trí bắt đầu các tile dọc một cạnh.
+std::vector<int> TileStarts(int length, int tile, int overlap) {
+    std::vector<int> starts;
+    if (length <= tile) {
+        starts.push_back(0);
+        return starts;
+    }
+    int step = std::max(1, tile - overlap);
+    for (int s = 0;; s += step) {
+        if (s + tile >= length) {
+            starts.push_back(length - tile);
+            break;
+        }
+        starts.push_back(s);
+    }
+    return starts;
+}
+
+// Thông tin hình học của một box dùng khi so khớp.
+struct BoxGeom {
+    cv::Rect rect;        // hình chữ nhật bao thẳng trục
+    cv::Point2f center;
+    float height = 0.f;   // cạnh ngắn của hình chữ nhật xoay
+    float angle = 0.f;    // hướng cạnh dài, độ trong [0, 180)
+    cv::Point2f dir;      // vector đơn vị theo cạnh dài
+};
+
+BoxGeom MakeGeom(const Quad &box) {
+    std::vector<cv::Point> pts;
+    for (const auto &pt : box.pts)
+        pts.emplace_back(static_cast<int>(pt.x), static_cast<int>(pt.y));
+    BoxGeom g;
+    g.rect = cv::boundingRect(pts);
+    cv::RotatedRect rr = cv::minAreaRect(pts);
+    g.center = rr.center;
+    float angle = rr.angle;
+    if (rr.size.width < rr.size.height) {
+        angle += 90.f;
+        g.height = rr.size.width;
+    } else {
+        g.height = rr.size.height;
+    }
+    angle = std::fmod(angle + 360.f, 180.f);
+    g.angle = angle;
+    float rad = angle * static_cast<float>(CV_PI) / 180.f;
+    g.dir = cv::Point2f(std::cos(rad), std::sin(rad));
+    return g;
+}
+
+bool ShouldMerge(const BoxGeom &a, const BoxGeom &b, float iou_thresh) {
+    int inter = (a.rect & b.rect).area();
+    int area_a = a.rect.area();
+    int area_b = b.rect.area();
+    if (inter > 0) {
+        float iou = static_cast<float>(inter) / (area_a + area_b - inter);
+        float cover = static_cast<float>(inter) / std::max(1, std::min(area_a, area_b));
+        if (iou > iou_thresh || cover > 0.8f)
+            return true;
+    }
+
+    // Kiểm tra thẳng hàng: hai nửa của cùng một dòng chữ.
+    float h_min = std::min(a.height, b.height);
+    float h_max = std::max(a.height, b.height);
+    if (h_min <= 0.f || h_min / h_max < 0.6f)
+        return false;
+    float d_angle = std::fabs(a.angle - b.angle);
+    d_angle = std::min(d_angle, 180.f - d_angle);
+    if (d_angle > 10.f)
+        return false;
+    // Độ lệch tâm theo phương vuông góc với dòng chữ.
+    cv::Point2f d = b.center - a.center;
+    float perp = std::fabs(d.x * -a.dir.y + d.y * a.dir.x);
+    if (perp > 0.5f * h_min)
+        return false;
+    // Khoảng hở dọc theo dòng giữa hai box phải nhỏ (chạm hoặc chồng lên nhau).
+    float along = std::fabs(d.x * a.dir.x + d.y * a.dir.y);
+    float half_len_a = 0.5f * std::fabs(a.rect.width * a.dir.x) + 0.5f * std::fabs(a.rect.height * a.dir.y);
+    float half_len_b = 0.5f * std::fabs(b.rect.width * b.dir.x) + 0.5f * std::fabs(b.rect.height * b.dir.y);
+    return along - half_len_a - half_len_b <= 0.5f * h_min;
+}
+
+int FindRoot(std::vector<int> &parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+} // namespace
+
+std::vector<cv::Rect> PlanTiles(const cv::Size &image, int tile_w, int tile_h, int overlap) {
+    tile_w = std::max(32, tile_w);
+    tile_h = std::max(32, tile_h);
+    overlap = std::max(0, overlap);
+    std::vector<cv::Rect> tiles;
+    for (int y : TileStarts(image.height, tile_h, overlap)) {
+        for (int x : TileStarts(image.width, tile_w, overlap)) {
+            tiles.emplace_back(x, y, std::min(tile_w, image.width), std::min(tile_h, image.height));
+        }
+    }
+    return tiles;
+}
+
+int TileSideForCount(int length, int count, int overlap) {
+    count = std::max(1, count);
+    return (length + (count - 1) * overlap + count - 1) / count;
+}
+
+std::vector<cv::Rect> MergeOverlappingRects(std::vector<cv::Rect> rects, int gap) {
+    // Mỗi lượt: quét theo x tăng dần, gộp các cặp chạm nhau bằng union-find. Hình bao của một nhóm có thể
+    // chạm hình khác mà không thành viên nào chạm, nên lặp lại trên kết quả đến khi số hình không đổi
+    // (thường một, hai lượt).
+    for (;;) {
+        const int n = static_cast<int>(rects.size());
+        std::vector<int> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int i, int j) { return rects[i].x < rects[j].x; });
+        std::vector<int> parent(n);
+        std::iota(parent.begin(), parent.end(), 0);
+        auto find = [&](int i) {
+            while (parent[i] != i)
+                i = parent[i] = parent[parent[i]];
+            return i;
+        };
+        for (int oi = 0; oi < n; oi++) {
+            const cv::Rect &a = rects[order[oi]];
+            const cv::Rect grown(a.x - gap, a.y - gap, a.width + 2 * gap, a.height + 2 * gap);
+            for (int oj = oi + 1; oj < n; oj++) {
+                const cv::Rect &b = rects[order[oj]];
+                if (b.x >= grown.x + grown.width)
+                    break;
+                if ((grown & b).area() > 0)
+                    parent[find(order[oj])] = find(order[oi]);
+            }
+        }
+        std::vector<cv::Rect> merged;
+        std::vector<int> slot(n, -1);
+        for (int i = 0; i < n; i++) {
+            const int root = find(i);
+            if (slot[root] < 0) {
+                slot[root] = static_cast<int>(merged.size());
+                merged.push_back(rects[i]);
+            } else {
+                merged[slot[root]] = merged[slot[root]] | rects[i];
+            }
+        }
+        const bool done = merged.size() == rects.size();
+        rects.swap(merged);
+        if (done)
+            return rects;
+    }
+}
+
+std::vector<Quad> MergeTileBoxes(const std::vector<Quad> &boxes, const std::vector<int> &tile_ids,
+                                 float iou_thresh) {
+    const int n = static_cast<int>(boxes.size());
+    std::vector<BoxGeom> geoms;
+    geoms.reserve(n);
+    for (const auto &box : boxes)
+        geoms.push_back(MakeGeom(box));
+
+    // Duyệt theo x tăng dần để cắt sớm các cặp ở quá xa nhau.
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](int i, int j) { return geoms[i].rect.x < geoms[j].rect.x; });
+
+    std::vector<int> parent(n);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (int oi = 0; oi < n; oi++) {
+        const BoxGeom &a = geoms[order[oi]];
+        int reach = a.rect.x + a.rect.width + static_cast<int>(a.height) + 1;
+        for (int oj = oi + 1; oj < n; oj++) {
+            const BoxGeom &b = geoms[order[oj]];
+            if (b.rect.x > reach)
+                break;
+            if (tile_ids[order[oi]] == tile_ids[order[oj]])
+                continue;
+            if (ShouldMerge(a, b, iou_thresh)) {
+                int ra = FindRoot(parent, order[oi]);
+                int rb = FindRoot(parent, order[oj]);
+                if (ra != rb)
+                    parent[rb] = ra;
+            }
+        }
+    }
+
+    std::vector<std::vector<cv::Point>> groups(n);
+    std::vector<float> group_score(n, 0.f);
+    for (int i = 0; i < n; i++) {
+        int root = FindRoot(parent, i);
+        auto &g = groups[root];
+        for (const auto &pt : boxes[i].pts)
+            g.emplace_back(static_cast<int>(pt.x), static_cast<int>(pt.y));
+        group_score[root] = std::max(group_score[root], boxes[i].score);
+    }
+
+    std::vector<Quad> merged;
+    merged.reserve(n);
+    for (int i = 0; i < n; i++) {
+        if (groups[i].empty())
+            continue;
+        if (groups[i].size() == 4 && FindRoot(parent, i) == i) {
+            merged.push_back(boxes[i]);
+            continue;
+        }
+        cv::Point2f corners[4];
+        cv::minAreaRect(groups[i]).points(corners);
+        Quad box;
+        for (int k = 0; k < 4; k++)
+            box.pts[k] = {std::round(corners[k].x), std::round(corners[k].y)};
+        box.score = group_score[i];
+        merged.push_back(OrderPointsClockwise(box));
+    }
+    return merged;
+}
+
+} // namespace ocr
@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include "opencv2/core.hpp"
+#include "quad.h"
+
+namespace ocr {
+
+// Chia ảnh kích thước image thành lưới tile tile_w x tile_h chồng lấn nhau overlap pixel.
+// Tile cuối mỗi hàng/cột được dời vào trong để mọi tile có cùng kích thước
+// (trừ khi ảnh nhỏ hơn tile, khi đó tile chính là toàn bộ cạnh ảnh).
+std::vector<cv::Rect> PlanTiles(const cv::Size &image, int tile_w, int tile_h, int overlap);
+
+// Kích thước tile để phủ một cạnh dài length bằng count tile chồng lấn overlap pixel.
+int TileSideForCount(int length, int count, int overlap);
+
+// Gộp các hình chữ nhật chồng lên nhau (hoặc cách nhau không quá gap pixel) thành hình bao chung,
+// đến khi không còn cặp nào chạm nhau (quét theo x + union-find, lặp lại chỉ khi hình bao mới chạm thêm).
+std::vector<cv::Rect> MergeOverlappingRects(std::vector<cv::Rect> rects, int gap);
+
+// Gộp các box thu được từ nhiều tile (đã ở tọa độ ảnh gốc).
+// Hai box của hai tile khác nhau được gộp khi chúng trùng nhau (IoU > iou_thresh hoặc box
+// nhỏ nằm gần trọn trong box lớn), hoặc khi chúng là hai nửa của cùng một dòng chữ bị
+// đường nối cắt ngang: cùng hướng, chiều cao tương đương, thẳng hàng và chạm / chồng nhau.
+// Box gộp là hình chữ nhật xoay nhỏ nhất bao tất cả các điểm, theo thứ tự chiều kim đồng hồ,
+// với score lớn nhất trong nhóm.
+std::vector<Quad> MergeTileBoxes(const std::vector<Quad> &boxes, const std::vector<int> &tile_ids,
+                                 float iou_thresh);
+
+} // namespace ocr
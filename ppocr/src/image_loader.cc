@@ -0,0 +1,186 @@
+#include "image_loader.h"
+#include "det_process.h"  // CropBox
+#include "opencv2/imgcodecs.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace ocr {
+
+namespace {
+
+int ReadBigEndian16(std::istream &in) {
+    unsigned char b[2];
+    if (!in.read(reinterpret_cast<char *>(b), 2))
+        return -1;
+    return (b[0] << 8) | b[1];
+}
+
+bool ReadPngSize(std::istream &in, cv::Size &size) {
+    // Chữ ký 8 byte, chunk IHDR: length(4) + "IHDR"(4) + width(4) + height(4).
+    unsigned char h[24];
+    if (!in.read(reinterpret_cast<char *>(h), 24))
+        return false;
+    if (h[12] != 'I' || h[13] != 'H' || h[14] != 'D' || h[15] != 'R')
+        return false;
+    size.width = (h[16] << 24) | (h[17] << 16) | (h[18] << 8) | h[19];
+    size.height = (h[20] << 24) | (h[21] << 16) | (h[22] << 8) | h[23];
+    return size.width > 0 && size.height > 0;
+}
+
+bool ReadJpegSize(std::istream &in, cv::Size &size) {
+    in.seekg(2);
+    while (in) {
+        int c = in.get();
+        if (c != 0xFF)
+            return false;
+        int marker = in.get();
+        while (marker == 0xFF)
+            marker = in.get();
+        if (marker < 0)
+            return false;
+        // Marker không có phần độ dài.
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+            continue;
+        int length = ReadBigEndian16(in);
+        if (length < 2)
+            return false;
+        // SOF0..SOF15 (trừ DHT, JPG, DAC) chứa kích thước khung ảnh.
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            in.get();  // precision
+            size.height = ReadBigEndian16(in);
+            size.width = ReadBigEndian16(in);
+            return size.width > 0 && size.height > 0;
+        }
+        if (marker == 0xDA || marker == 0xD9)
+            return false;
+        in.seekg(length - 2, std::ios::cur);
+    }
+    return false;
+}
+
+bool IsJpeg(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return in.get() == 0xFF && in.get() == 0xD8;
+}
+
+// Cờ imread cho hệ số thu nhỏ reduction (1, 2, 4, 8).
+int ReducedColorFlags(int reduction) {
+    switch (reduction) {
+    case 2:
+        return cv::IMREAD_REDUCED_COLOR_2;
+    case 4:
+        return cv::IMREAD_REDUCED_COLOR_4;
+    case 8:
+        return cv::IMREAD_REDUCED_COLOR_8;
+    default:
+        return cv::IMREAD_COLOR;
+    }
+}
+
+// Chiều cao (cạnh trái / phải dài hơn) của box.
+float BoxHeight(const Quad &box) {
+    const QuadPoint *p = box.pts;
+    return std::max(std::hypot(p[0].x - p[3].x, p[0].y - p[3].y), std::hypot(p[1].x - p[2].x, p[1].y - p[2].y));
+}
+
+} // namespace
+
+bool ReadImageSize(const std::string &path, cv::Size &size) {
+    std::ifstream in(path, std::ios::binary);
+    unsigned char sig[2];
+    if (!in.read(reinterpret_cast<char *>(sig), 2))
+        return false;
+    in.seekg(0);
+    if (sig[0] == 0xFF && sig[1] == 0xD8)
+        return ReadJpegSize(in, size);
+    if (sig[0] == 0x89 && sig[1] == 'P')
+        return ReadPngSize(in, size);
+    return false;
+}
+
+int ChooseDecodeReduction(const cv::Size &size, int min_long_side) {
+    int long_side = std::max(size.width, size.height);
+    if (min_long_side <= 0 || long_side <= 0)
+        return 1;
+    int reduction = 1;
+    for (int r : {2, 4, 8}) {
+        // IMREAD_REDUCED_* làm tròn lên khi chia.
+        if ((long_side + r - 1) / r >= min_long_side)
+            reduction = r;
+    }
+    return reduction;
+}
+
+DecodedImage LoadImageForDetection(const std::string &path, int min_long_side) {
+    DecodedImage result;
+    result.path = path;
+    int flags = cv::IMREAD_COLOR;
+    // Chỉ JPEG được thu nhỏ thật sự trong bước decode; PNG vẫn phải giải mã toàn bộ.
+    if (ReadImageSize(path, result.original_size) && IsJpeg(path))
+        flags = ReducedColorFlags(ChooseDecodeReduction(result.original_size, min_long_side));
+    result.image = cv::imread(path, flags);
+    if (result.image.empty())
+        return result;
+    if (flags == cv::IMREAD_COLOR) {
+        // Ảnh đầy đủ: dùng luôn làm bản gốc, không cần decode lại khi crop.
+        result.detail = result.image;
+        result.original_size = result.image.size();
+        result.scale = 1.f;
+    } else {
+        // Kích thước theo header chưa xoay theo EXIF, nên so sánh cạnh dài với cạnh dài.
+        int orig_long = std::max(result.original_size.width, result.original_size.height);
+        result.scale = static_cast<float>(std::max(result.image.cols, result.image.rows)) / orig_long;
+    }
+    return result;
+}
+
+void PrepareRecognitionSource(DecodedImage &img, const std::vector<Quad> &boxes, int min_crop_height) {
+    if (img.scale >= 1.f || min_crop_height <= 0 || !img.detail.empty())
+        return;
+    float min_height = static_cast<float>(min_crop_height);
+    for (const Quad &box : boxes)
+        min_height = std::min(min_height, BoxHeight(box));
+    if (min_height >= min_crop_height)
+        return;
+    // Box thấp nhất cần được phóng min_crop_height / min_height lần so với img.image: chọn mức thu nhỏ lớn
+    // nhất mà cạnh dài sau decode vẫn đạt độ phân giải đó.
+    const int orig_long = std::max(img.original_size.width, img.original_size.height);
+    const float needed_scale = img.scale * min_crop_height / std::max(1.f, min_height);
+    const int reduction = ChooseDecodeReduction(img.original_size,
+                                                static_cast<int>(std::ceil(orig_long * std::min(1.f, needed_scale))));
+    const int current = static_cast<int>(std::lround(1.f / img.scale));
+    if (reduction >= current)
+        return;
+    img.detail = cv::imread(img.path, ReducedColorFlags(reduction));
+    if (img.detail.empty())
+        return;
+    img.detail_scale = static_cast<float>(std::max(img.detail.cols, img.detail.rows)) / orig_long;
+}
+
+const cv::Mat &SourceForRecognition(DecodedImage &img, const Quad &box, int min_crop_height, Quad &src_box) {
+    src_box = box;
+    if (img.scale >= 1.f || min_crop_height <= 0 || BoxHeight(box) >= min_crop_height)
+        return img.image;
+
+    if (img.detail.empty()) {
+        PrepareRecognitionSource(img, {box}, min_crop_height);
+        if (img.detail.empty())
+            return img.image;
+    }
+    const float inv_x = static_cast<float>(img.detail.cols) / img.image.cols;
+    const float inv_y = static_cast<float>(img.detail.rows) / img.image.rows;
+    for (auto &pt : src_box.pts) {
+        pt.x = std::min(std::round(pt.x * inv_x), static_cast<float>(img.detail.cols - 1));
+        pt.y = std::min(std::round(pt.y * inv_y), static_cast<float>(img.detail.rows - 1));
+    }
+    return img.detail;
+}
+
+cv::Mat CropForRecognition(DecodedImage &img, const Quad &box, int min_crop_height) {
+    Quad src_box;
+    const cv::Mat &src = SourceForRecognition(img, box, min_crop_height, src_box);
+    return CropBox(src, src_box);
+}
+
+} // namespace ocr
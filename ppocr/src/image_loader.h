@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "opencv2/core.hpp"
+#include "quad.h"
+
+namespace ocr {
+
+// Ảnh đã giải mã cho pipeline, có thể đã được thu nhỏ ngay lúc decode.
+struct DecodedImage {
+    std::string path;
+    cv::Mat image;            // ảnh dùng cho detection (có thể là bản thu nhỏ 1/2, 1/4, 1/8)
+    cv::Size original_size;   // kích thước ảnh gốc theo header (0x0 nếu không đọc được)
+    float scale = 1.f;        // image.cols / chiều rộng gốc
+    cv::Mat detail;           // ảnh decode lại cho recognition (gốc hoặc thu nhỏ ít hơn image), rỗng đến khi cần
+    float detail_scale = 1.f; // detail.cols / chiều rộng gốc
+};
+
+// Chiều cao box (pixel trên ảnh nguồn) mặc định dưới đó box được crop từ ảnh decode lại: mô hình
+// recognition phóng box lên chiều cao 48, box thấp hơn 24 pixel sẽ bị phóng hơn 2 lần.
+constexpr int kDefaultMinCropHeight = 24;
+
+// Đọc kích thước ảnh JPEG/PNG từ header mà không giải mã ảnh. Trả về false nếu không đọc được.
+bool ReadImageSize(const std::string &path, cv::Size &size);
+
+// Hệ số thu nhỏ khi decode (1, 2, 4 hoặc 8) lớn nhất mà cạnh dài sau decode vẫn >= min_long_side.
+int ChooseDecodeReduction(const cv::Size &size, int min_long_side);
+
+// Đọc ảnh cho detection: với JPEG, đọc header trước rồi decode bằng cv::IMREAD_REDUCED_COLOR_2/4/8
+// sao cho cạnh dài vẫn không nhỏ hơn min_long_side (libjpeg thu nhỏ ngay trong bước IDCT nên nhanh
+// và tốn ít bộ nhớ hơn decode đầy đủ rồi resize). min_long_side <= 0 tắt việc thu nhỏ.
+// Trả về DecodedImage với image rỗng nếu không đọc được.
+DecodedImage LoadImageForDetection(const std::string &path, int min_long_side);
+
+// Decode lại ảnh (một lần) vào img.detail cho các box (tọa độ trên img.image) thấp hơn min_crop_height
+// pixel: chỉ ở mức thu nhỏ 1/2, 1/4 (hoặc ảnh gốc) vừa đủ để box thấp nhất đạt min_crop_height, không
+// decode lại toàn bộ độ phân giải gốc khi không cần. Không làm gì nếu img.image chưa bị thu nhỏ, không box
+// nào quá thấp hoặc img.detail đã có. Gọi trước SourceForRecognition với mọi box của ảnh.
+void PrepareRecognitionSource(DecodedImage &img, const std::vector<Quad> &boxes, int min_crop_height);
+
+// Chọn ảnh nguồn để crop box cho recognition: img.image, hoặc img.detail nếu ảnh đã bị thu nhỏ và chiều
+// cao box trên ảnh thu nhỏ nhỏ hơn min_crop_height pixel (img.detail được decode cho riêng box này nếu
+// chưa có PrepareRecognitionSource). src_box nhận tọa độ box trên ảnh được chọn. Dùng với
+// RecProcess::recognize(src, src_box) để khỏi tạo ảnh crop trung gian.
+const cv::Mat &SourceForRecognition(DecodedImage &img, const Quad &box, int min_crop_height, Quad &src_box);
+
+// Crop vùng chữ cho recognition từ box theo tọa độ của img.image.
+// Nếu ảnh đã bị thu nhỏ và chiều cao box trên ảnh thu nhỏ nhỏ hơn min_crop_height pixel,
+// ảnh được decode lại (một lần, lưu trong img.detail, xem PrepareRecognitionSource) và crop trên đó.
+// min_crop_height <= 0: luôn crop trên ảnh đã thu nhỏ.
+cv::Mat CropForRecognition(DecodedImage &img, const Quad &box, int min_crop_height);
+
+} // namespace ocr
@@ -0,0 +1,191 @@
+#include "keyword_spotter.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+
+namespace ocr {
+
+KeywordSet::KeywordSet(const std::vector<std::string> &keywords, const std::vector<std::string> &char_list)
+    : column_of_label_(char_list.size(), 0) {
+    const CharListIndex index(char_list);
+    std::vector<int> labels;
+    for (const std::string &keyword : keywords) {
+        Entry entry;
+        entry.text = keyword;
+        if (index.split(keyword, labels))
+            entry.labels = labels;
+        entries_.push_back(entry);
+        labels_.insert(labels_.end(), entry.labels.begin(), entry.labels.end());
+    }
+    std::sort(labels_.begin(), labels_.end());
+    labels_.erase(std::unique(labels_.begin(), labels_.end()), labels_.end());
+    for (size_t k = 0; k < labels_.size(); k++)
+        column_of_label_[labels_[k]] = static_cast<int>(k) + 1;
+    for (Entry &entry : entries_) {
+        for (int label : entry.labels)
+            entry.columns.push_back(column_of_label_[label]);
+    }
+}
+
+void KeywordFrames::appendStep(const KeywordFrames &src, size_t t) {
+    width = src.width;
+    greedy.push_back(src.greedy[t]);
+    step.push_back(src.step[t]);
+    probs.insert(probs.end(), src.probs.begin() + t * width, src.probs.begin() + (t + 1) * width);
+}
+
+void AppendKeywordFrames(const float *probs, int steps, int num_classes, int first_step,
+                         const KeywordSet &keywords, KeywordFrames &frames) {
+    const std::vector<int> &labels = keywords.labels();
+    frames.width = 1 + static_cast<int>(labels.size());
+    const size_t old = frames.size();
+    frames.greedy.resize(old + steps);
+    frames.step.resize(old + steps);
+    frames.probs.resize((old + steps) * frames.width);
+    // Lớp argmax gần nhất không thuộc từ khóa: thường vẫn thắng ở bước sau (ký tự kéo dài nhiều bước).
+    int probe = -1;
+    for (int t = 0; t < steps; t++) {
+        const float *row = probs + static_cast<size_t>(t) * num_classes;
+        float *out = frames.probs.data() + (old + t) * frames.width;
+        out[0] = row[0];
+        float best = -1.f;
+        int best_label = 0;
+        for (size_t k = 0; k < labels.size(); k++) {
+            out[k + 1] = labels[k] < num_classes ? row[labels[k]] : 0.f;
+            if (out[k + 1] > best) {
+                best = out[k + 1];
+                best_label = labels[k];
+            }
+        }
+        // Chỉ quét cả hàng khi một lớp của từ khóa có thể là argmax mà chưa chắc chắn.
+        int greedy;
+        if (best <= row[0] || (probe >= 0 && row[probe] > best)) {
+            greedy = 0;
+        } else if (best > 0.5f) {
+            greedy = best_label;
+        } else {
+            float value;
+            ArgmaxRows(row, 1, num_classes, &greedy, &value);
+            if (keywords.column(greedy) == 0 && greedy != 0)
+                probe = greedy;
+        }
+        frames.greedy[old + t] = greedy;
+        frames.step[old + t] = first_step + t;
+    }
+}
+
+void ScoreKeywords(const KeywordFrames &frames, const KeywordSet &keywords, float threshold, size_t crop,
+                   std::vector<KeywordHit> &hits) {
+    const int steps = static_cast<int>(frames.size());
+    const int width = frames.width;
+    // Cột và cặp cột liền nhau trên chuỗi greedy đã gộp CTC; dòng không có cột nào thì không thể chứa từ khóa nào.
+    thread_local std::vector<char> present;
+    thread_local std::vector<uint32_t> bigrams;
+    present.assign(width, 0);
+    bigrams.clear();
+    bool any = false;
+    int prev_label = 0, prev_column = -1;
+    for (int label : frames.greedy) {
+        if (label != 0 && label != prev_label) {
+            const int c = keywords.column(label);
+            if (c > 0) {
+                present[c] = 1;
+                any = true;
+                if (prev_column > 0)
+                    bigrams.push_back(static_cast<uint32_t>(prev_column) * width + c);
+            }
+            prev_column = c;
+        }
+        prev_label = label;
+    }
+    if (!any || steps == 0)
+        return;
+    std::sort(bigrams.begin(), bigrams.end());
+    // Từ khóa được chấm khi chuỗi greedy có chung một cặp ký tự liền nhau của nó (hoặc ký tự duy nhất),
+    // nên một ký tự đọc sai không làm mất từ khóa mà các dòng chỉ trùng ký tự rời rạc bị bỏ qua.
+    auto candidate = [&](const KeywordSet::Entry &entry) {
+        if (entry.columns.size() == 1)
+            return present[entry.columns[0]] != 0;
+        for (size_t i = 0; i + 1 < entry.columns.size(); i++) {
+            const uint32_t key = static_cast<uint32_t>(entry.columns[i]) * width + entry.columns[i + 1];
+            if (std::binary_search(bigrams.begin(), bigrams.end(), key))
+                return true;
+        }
+        return false;
+    };
+
+    // Log xác suất theo cột, chỉ tính cho cột mà một từ khóa được chấm cần tới.
+    thread_local std::vector<float> log_probs;
+    thread_local std::vector<char> ready;
+    log_probs.resize(static_cast<size_t>(steps) * width);
+    ready.assign(width, 0);
+    auto column = [&](int c) {
+        if (!ready[c]) {
+            for (int t = 0; t < steps; t++)
+                log_probs[static_cast<size_t>(t) * width + c] =
+                    std::log(std::max(frames.probs[static_cast<size_t>(t) * width + c], 1e-30f));
+            ready[c] = 1;
+        }
+    };
+    column(0);
+
+    // Trạng thái mở rộng của từ khóa: ký tự 0, blank, ký tự 1, ..., ký tự L - 1 (không có blank đầu / cuối).
+    const float kDead = -std::numeric_limits<float>::infinity();
+    thread_local std::vector<float> score, next_score;
+    thread_local std::vector<int> start, next_start;
+    for (int k = 0; k < keywords.size(); k++) {
+        const KeywordSet::Entry &entry = keywords.entry(k);
+        const int length = static_cast<int>(entry.columns.size());
+        if (length == 0 || length > steps || !candidate(entry))
+            continue;
+        for (int c : entry.columns)
+            column(c);
+
+        const int states = 2 * length - 1;
+        score.assign(states, kDead);
+        start.assign(states, 0);
+        float best_mean = kDead;
+        int best_start = 0, best_end = 0;
+        for (int t = 0; t < steps; t++) {
+            const float *lp = log_probs.data() + static_cast<size_t>(t) * width;
+            next_score.resize(states);
+            next_start.resize(states);
+            // Bắt đầu từ khóa tại bước t luôn tốt hơn kéo dài ký tự đầu (log xác suất <= 0).
+            next_score[0] = lp[entry.columns[0]];
+            next_start[0] = t;
+            for (int j = 1; j < states; j++) {
+                // Ứng viên từ bước trước: ở lại, từ trạng thái trước, hoặc bỏ qua blank giữa hai ký tự khác nhau.
+                float best = score[j];
+                int from = j;
+                if (score[j - 1] > best) {
+                    best = score[j - 1];
+                    from = j - 1;
+                }
+                if (j % 2 == 0 && j >= 2 && entry.labels[j / 2] != entry.labels[j / 2 - 1] && score[j - 2] > best) {
+                    best = score[j - 2];
+                    from = j - 2;
+                }
+                const float emit = j % 2 == 0 ? lp[entry.columns[j / 2]] : lp[0];
+                next_score[j] = best + emit;
+                next_start[j] = start[from];
+            }
+            score.swap(next_score);
+            start.swap(next_start);
+            if (score[states - 1] != kDead) {
+                const float mean = score[states - 1] / (t - start[states - 1] + 1);
+                if (mean > best_mean) {
+                    best_mean = mean;
+                    best_start = start[states - 1];
+                    best_end = t;
+                }
+            }
+        }
+        const float match = best_mean == kDead ? 0.f : std::exp(best_mean);
+        if (match >= threshold)
+            hits.push_back(KeywordHit{crop, k, match, frames.step[best_start], frames.step[best_end] + 1, Quad{}});
+    }
+}
+
+} // namespace ocr
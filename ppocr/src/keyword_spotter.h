@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "ctc_decoder.h"
+#include "quad.h"
+
+namespace ocr {
+
+// Một lần tìm thấy từ khóa: crop (chỉ số đầu vào), từ khóa (chỉ số trong KeywordSet), điểm căn chỉnh CTC
+// (trung bình nhân xác suất trên các bước của từ khóa, 0..1), khoảng bước thời gian [start_step, end_step)
+// trên cả dòng và vùng của từ khóa trên ảnh nguồn của crop.
+struct KeywordHit {
+    size_t crop;
+    int keyword;
+    float score;
+    int start_step;
+    int end_step;
+    Quad box;
+};
+
+// Tập từ khóa đã tách thành các lớp của từ điển ký tự, kèm tập lớp dùng chung để chỉ giữ các cột cần thiết
+// của output recognition. Từ khóa có ký tự ngoài từ điển không bao giờ được tìm thấy.
+class KeywordSet {
+public:
+    KeywordSet(const std::vector<std::string> &keywords, const std::vector<std::string> &char_list);
+
+    // Một từ khóa: lớp từ điển của từng ký tự (rỗng nếu có ký tự ngoài từ điển) và cột tương ứng trong
+    // KeywordFrames.
+    struct Entry {
+        std::string text;
+        std::vector<int> labels;
+        std::vector<int> columns;
+    };
+
+    int size() const { return static_cast<int>(entries_.size()); }
+    const Entry &entry(int i) const { return entries_[i]; }
+
+    // Các lớp được dùng bởi ít nhất một từ khóa (tăng dần); cột 1 + k của KeywordFrames là lớp labels()[k].
+    const std::vector<int> &labels() const { return labels_; }
+    // Cột của lớp label trong KeywordFrames, 0 nếu không từ khóa nào dùng lớp đó.
+    int column(int label) const {
+        return label > 0 && label < static_cast<int>(column_of_label_.size()) ? column_of_label_[label] : 0;
+    }
+
+private:
+    std::vector<Entry> entries_;
+    std::vector<int> labels_;
+    std::vector<int> column_of_label_;
+};
+
+// Output recognition rút gọn cho dò từ khóa: mỗi bước giữ xác suất của blank cùng các lớp trong
+// KeywordSet::labels() (width cột) và lớp argmax (đường greedy, để loại sớm). greedy chỉ chính xác với lớp
+// của từ khóa: bước mà argmax chắc chắn không phải lớp của từ khóa (thua blank hoặc thua lớp argmax trước
+// đó) ghi 0 mà không quét cả hàng, nên phép loại sớm không bao giờ bỏ sót so với đường greedy thật.
+struct KeywordFrames {
+    std::vector<int> greedy;
+    std::vector<int> step;
+    std::vector<float> probs;
+    int width = 0;
+
+    size_t size() const { return greedy.size(); }
+    // Bước t là blank trên đường greedy.
+    bool isBlank(size_t t) const { return greedy[t] == 0; }
+    // Nối bước t của src vào cuối.
+    void appendStep(const KeywordFrames &src, size_t t);
+};
+
+// Nối steps bước output (num_classes xác suất mỗi bước) vào frames; bước đầu tiên có chỉ số first_step.
+void AppendKeywordFrames(const float *probs, int steps, int num_classes, int first_step,
+                         const KeywordSet &keywords, KeywordFrames &frames);
+
+// Chấm điểm mọi từ khóa trên một dòng và nối vào hits các từ khóa có điểm >= threshold (box để trống).
+// Dòng mà đường greedy không có ký tự nào của từ khóa nào bị loại ngay; với dòng còn lại, chỉ từ khóa có
+// chung ít nhất một cặp ký tự liền nhau (hoặc ký tự duy nhất) với chuỗi greedy đã gộp được chấm. Điểm là
+// căn chỉnh CTC tốt nhất (Viterbi) của từ khóa trên một đoạn bước liên tiếp bất kỳ của dòng (ngoài đoạn đó
+// không ràng buộc), quy về trung bình log xác suất mỗi bước của đoạn.
+void ScoreKeywords(const KeywordFrames &frames, const KeywordSet &keywords, float threshold, size_t crop,
+                   std::vector<KeywordHit> &hits);
+
+} // namespace ocr
@@ -5,8 +5,11 @@
 #include <string>
 #include <algorithm>
 #include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
 #include "det_process.h"
-#include "rec_process.h"
+#include "image_loader.h"
+#include "rec_pool.h"
+#include "text_crop.h"
 
 namespace fs = std::filesystem;
 using namespace ocr;
@@ -30,7 +33,7 @@ int main() {
     int cpu_threads = 4;
     std::string cpu_power_mode = "LITE_POWER_HIGH";
     DetProcess detector(det_model_path, cpu_threads, cpu_power_mode);
-    RecProcess recognizer(rec_model_path, char_dict_path);
+    RecPool recognizer(rec_model_path, char_dict_path, 4);
     
     // Cấu hình cho detection
     std::map<std::string, double> detConfig;
@@ -38,6 +41,12 @@ int main() {
     detConfig["det_db_thresh"] = 0.8;         // Ngưỡng detection
     detConfig["det_db_unclip_ratio"] = 1.5;  
     detConfig["det_db_use_dilate"] = 0;
+    detConfig["rec_min_crop_height"] = kDefaultMinCropHeight; // Box thấp hơn được crop từ ảnh decode lại.
+    
+    // Cấu hình cho recognition
+    std::map<std::string, double> recConfig;
+    recConfig["rec_batch_size"] = 8;
+    recognizer.warmUp(static_cast<int>(recConfig["rec_batch_size"]));
     
     // Duyệt qua từng ảnh trong thư mục input.
     for (const auto &entry : fs::directory_iterator(input_dir)) {
@@ -47,7 +56,9 @@ int main() {
         std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
         if (ext != ".jpg" && ext != ".jpeg" && ext != ".png") continue;
         
-        cv::Mat image = cv::imread(file_path);
+        // Decode JPEG thu nhỏ sẵn nhưng cạnh dài vẫn >= max_side_len.
+        DecodedImage decoded = LoadImageForDetection(file_path, static_cast<int>(detConfig["max_side_len"]));
+        cv::Mat image = decoded.image;
         if (image.empty()) {
             std::cerr << "Không thể tải ảnh: " << file_path << std::endl;
             continue;
@@ -56,31 +67,37 @@ int main() {
         // Chạy detection.
         auto boxes = detector.detect(image, detConfig);
         
-        // Vẽ box lên ảnh gốc.
+        // Với mỗi box hợp lệ, crop vùng chữ rồi nhận dạng theo lô (crop trước khi vẽ box lên ảnh).
+        const int rec_min_crop_height = static_cast<int>(detConfig["rec_min_crop_height"]);
+        PrepareRecognitionSource(decoded, boxes, rec_min_crop_height);
+        std::vector<RecCrop> crops;
+        for (const auto &box : boxes) {
+            // Box quá thấp trên ảnh thu nhỏ được crop lại từ ảnh decode lại.
+            Quad src_box;
+            const cv::Mat &source = SourceForRecognition(decoded, box, rec_min_crop_height, src_box);
+            // Có thể bổ sung bộ lọc dựa trên diện tích (ví dụ: bỏ box nhỏ)
+            if (CropSize(src_box).area() < 100)
+                continue;
+            crops.emplace_back(source, src_box);
+        }
+        for (const auto &rec_result : recognizer.recognizeAll(crops, recConfig)) {
+            std::cout << "Ảnh " << entry.path().filename().string() 
+                      << " -> text: " << rec_result.text 
+                      << " (confidence: " << rec_result.confidence << ")" << std::endl;
+        }
+        
+        // Vẽ box lên ảnh.
         for (const auto &box : boxes) {
             std::vector<cv::Point> pts;
-            for (const auto &pt : box) {
-                pts.push_back(cv::Point(pt[0], pt[1]));
+            for (const auto &pt : box.pts) {
+                pts.push_back(cv::Point(static_cast<int>(pt.x), static_cast<int>(pt.y)));
             }
-            if (pts.size() >= 4)
-                cv::polylines(image, pts, true, cv::Scalar(0, 0, 255), 2);
+            cv::polylines(image, pts, true, cv::Scalar(0, 0, 255), 2);
         }
         
         // Lưu ảnh detection.
         std::string output_path = det_output_dir + "/" + entry.path().filename().string();
         cv::imwrite(output_path, image);
-        
-        // Với mỗi box hợp lệ, crop vùng chữ và chạy recognition.
-        for (const auto &box : boxes) {
-            cv::Mat crop = CropBox(image, box);
-            // Có thể bổ sung bộ lọc dựa trên diện tích (ví dụ: bỏ box nhỏ)
-            if (cv::boundingRect(crop).area() < 100)
-                continue;
-            DecodeResult rec_result = recognizer.recognize(crop);
-            std::cout << "Ảnh " << entry.path().filename().string() 
-                      << " -> text: " << rec_result.text 
-                      << " (confidence: " << rec_result.confidence << ")" << std::endl;
-        }
     }
     return 0;
 }
@@ -0,0 +1,61 @@
+#pragma once
+#include <cmath>
+#include <vector>
+
+namespace ocr {
+
+// Một đỉnh của Quad.
+struct QuadPoint {
+    float x;
+    float y;
+};
+
+// Box văn bản 4 đỉnh dạng aggregate phẳng: tl, tr, br, bl (theo chiều kim đồng hồ), kèm điểm số và góc.
+// Lưu liền nhau trong std::vector<Quad>, nên cả danh sách box của một trang chỉ cần một lần cấp phát
+// (thay vì một vector cho mỗi điểm và mỗi box như std::vector<std::vector<std::vector<int>>>).
+struct Quad {
+    QuadPoint pts[4];
+    float score = 0.f;   // điểm trung bình xác suất của box (0 nếu không có)
+    float angle = 0.f;   // hướng cạnh tl -> tr, độ trong (-180, 180]
+};
+
+// Góc của cạnh tl -> tr, độ.
+inline float QuadAngle(const Quad &q) {
+    return std::atan2(q.pts[1].y - q.pts[0].y, q.pts[1].x - q.pts[0].x) * 57.29577951308232f;
+}
+
+// ---- Adapter cho API cũ dạng std::vector<std::vector<int>> (4 điểm {x, y}) ----
+
+inline std::vector<std::vector<int>> QuadToBox(const Quad &q) {
+    std::vector<std::vector<int>> box(4);
+    for (int i = 0; i < 4; i++)
+        box[i] = {static_cast<int>(std::lround(q.pts[i].x)), static_cast<int>(std::lround(q.pts[i].y))};
+    return box;
+}
+
+inline Quad BoxToQuad(const std::vector<std::vector<int>> &box, float score = 0.f) {
+    Quad q;
+    for (int i = 0; i < 4; i++)
+        q.pts[i] = {static_cast<float>(box[i][0]), static_cast<float>(box[i][1])};
+    q.score = score;
+    q.angle = QuadAngle(q);
+    return q;
+}
+
+inline std::vector<std::vector<std::vector<int>>> QuadsToBoxes(const std::vector<Quad> &quads) {
+    std::vector<std::vector<std::vector<int>>> boxes;
+    boxes.reserve(quads.size());
+    for (const auto &q : quads)
+        boxes.push_back(QuadToBox(q));
+    return boxes;
+}
+
+inline std::vector<Quad> BoxesToQuads(const std::vector<std::vector<std::vector<int>>> &boxes) {
+    std::vector<Quad> quads;
+    quads.reserve(boxes.size());
+    for (const auto &box : boxes)
+        quads.push_back(BoxToQuad(box));
+    return quads;
+}
+
+} // namespace ocr
@@ -0,0 +1,285 @@
+#include "rec_cache.h"
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <iterator>
+
+namespace ocr {
+
+namespace {
+
+constexpr int kHashRows = 8;
+constexpr int kHashCols = 33;
+// Tỷ lệ của khoảng sáng (max - min của các ô) dưới đó chênh lệch giữa hai ô bị bỏ qua.
+constexpr float kFlatMargin = 0.05f;
+// Chiều rộng (pixel input) của một ô ảnh thu nhỏ, và số cột của cửa sổ so sánh.
+constexpr int kThumbCellWidth = 3;
+constexpr int kThumbWindow = 8;
+
+} // namespace
+
+PerceptualHash HashRecInput(const float *input, int height, int width, int row_stride) {
+    PerceptualHash hash{};
+    if (height <= 0 || width <= 0)
+        return hash;
+    // Tổng ba kênh theo từng cột của mỗi dải hàng.
+    thread_local std::vector<float> bands;
+    bands.assign(static_cast<size_t>(kHashRows) * width, 0.f);
+    const size_t plane = static_cast<size_t>(height) * row_stride;
+    for (int y = 0; y < height; y++) {
+        float *band = bands.data() + static_cast<size_t>(y * kHashRows / height) * width;
+        const float *b = input + static_cast<size_t>(y) * row_stride;
+        const float *g = b + plane;
+        const float *r = g + plane;
+        for (int x = 0; x < width; x++)
+            band[x] += b[x] + g[x] + r[x];
+    }
+    // Trung bình mỗi ô (chiều rộng < kHashCols: các ô liền nhau dùng chung cột).
+    float cells[kHashRows][kHashCols];
+    for (int c = 0; c < kHashCols; c++) {
+        const int x0 = std::min(width - 1, c * width / kHashCols);
+        const int x1 = std::max(x0 + 1, (c + 1) * width / kHashCols);
+        for (int row = 0; row < kHashRows; row++) {
+            const float *band = bands.data() + static_cast<size_t>(row) * width;
+            float sum = 0.f;
+            for (int x = x0; x < x1; x++)
+                sum += band[x];
+            cells[row][c] = sum / (x1 - x0);
+        }
+    }
+    // Chênh lệch nhỏ hơn một phần tương phản của crop coi như bằng nhau (bit 0): ở vùng nền phẳng, dấu
+    // của chênh lệch chỉ là nhiễu và sẽ làm hai crop cùng nội dung khác nhau ở rất nhiều bit.
+    float lo = cells[0][0], hi = cells[0][0];
+    for (int row = 0; row < kHashRows; row++) {
+        for (int c = 0; c < kHashCols; c++) {
+            lo = std::min(lo, cells[row][c]);
+            hi = std::max(hi, cells[row][c]);
+        }
+    }
+    const float margin = kFlatMargin * (hi - lo);
+    for (int row = 0; row < kHashRows; row++) {
+        for (int c = 0; c + 1 < kHashCols; c++) {
+            if (cells[row][c] > cells[row][c + 1] + margin) {
+                const int bit = row * (kHashCols - 1) + c;
+                hash.bits[bit / 64] |= uint64_t(1) << (bit % 64);
+            }
+        }
+    }
+    return hash;
+}
+
+RecThumbnail ThumbnailRecInput(const float *input, int height, int width, int row_stride) {
+    constexpr int rows = RecThumbnail::kThumbRows;
+    RecThumbnail thumbnail;
+    if (height <= 0 || width <= 0)
+        return thumbnail;
+    const int cols = (width / RecCache::kWidthStep + 1) * (RecCache::kWidthStep / kThumbCellWidth);
+    // Tổng ba kênh theo từng cột của mỗi dải hàng, như HashRecInput.
+    thread_local std::vector<float> bands, cells;
+    bands.assign(static_cast<size_t>(rows) * width, 0.f);
+    const size_t plane = static_cast<size_t>(height) * row_stride;
+    for (int y = 0; y < height; y++) {
+        float *band = bands.data() + static_cast<size_t>(y * rows / height) * width;
+        const float *b = input + static_cast<size_t>(y) * row_stride;
+        const float *g = b + plane;
+        const float *r = g + plane;
+        for (int x = 0; x < width; x++)
+            band[x] += b[x] + g[x] + r[x];
+    }
+    cells.resize(static_cast<size_t>(rows) * cols);
+    for (int c = 0; c < cols; c++) {
+        const int x0 = std::min(width - 1, c * width / cols);
+        const int x1 = std::max(x0 + 1, (c + 1) * width / cols);
+        for (int row = 0; row < rows; row++) {
+            const int y0 = row * height / rows, y1 = std::max(y0 + 1, (row + 1) * height / rows);
+            const float *band = bands.data() + static_cast<size_t>(row) * width;
+            float sum = 0.f;
+            for (int x = x0; x < x1; x++)
+                sum += band[x];
+            cells[row * cols + c] = sum / ((x1 - x0) * (y1 - y0));
+        }
+    }
+    // Làm mờ 3x3 để lệch dưới một ô không làm đổi cả cạnh ký tự, rồi kéo giãn theo khoảng sáng của crop để
+    // độ sáng / tương phản thay đổi đều không làm lệch ảnh thu nhỏ.
+    thumbnail.cols = cols;
+    thumbnail.pixels.resize(static_cast<size_t>(rows) * cols);
+    thread_local std::vector<float> blurred;
+    blurred.resize(cells.size());
+    float lo = 0.f, hi = 0.f;
+    for (int row = 0; row < rows; row++) {
+        for (int c = 0; c < cols; c++) {
+            float sum = 0.f;
+            int n = 0;
+            for (int yy = std::max(0, row - 1); yy <= std::min(rows - 1, row + 1); yy++) {
+                for (int xx = std::max(0, c - 1); xx <= std::min(cols - 1, c + 1); xx++, n++)
+                    sum += cells[yy * cols + xx];
+            }
+            const float value = sum / n;
+            blurred[row * cols + c] = value;
+            lo = (row == 0 && c == 0) ? value : std::min(lo, value);
+            hi = (row == 0 && c == 0) ? value : std::max(hi, value);
+        }
+    }
+    const float scale = hi > lo ? 255.f / (hi - lo) : 0.f;
+    for (size_t i = 0; i < blurred.size(); i++)
+        thumbnail.pixels[i] = static_cast<uint8_t>(std::lround((blurred[i] - lo) * scale));
+    return thumbnail;
+}
+
+float ThumbnailDistance(const RecThumbnail &a, const RecThumbnail &b) {
+    constexpr int rows = RecThumbnail::kThumbRows;
+    const int cols = a.cols;
+    if (cols != b.cols || cols == 0)
+        return 1.f;
+    // Tổng bình phương chênh lệch theo từng cột của a khi b dịch (dx, dy) ô (mép được kéo dài).
+    thread_local std::vector<int64_t> column_error;
+    auto shiftedError = [&](int dx, int dy) {
+        column_error.assign(cols, 0);
+        int64_t total = 0;
+        for (int y = 0; y < rows; y++) {
+            const uint8_t *pa = a.pixels.data() + y * cols;
+            const uint8_t *pb = b.pixels.data() + std::min(rows - 1, std::max(0, y + dy)) * cols;
+            for (int x = 0; x < cols; x++) {
+                const int d = static_cast<int>(pa[x]) - static_cast<int>(pb[std::min(cols - 1, std::max(0, x + dx))]);
+                column_error[x] += d * d;
+            }
+        }
+        for (int x = 0; x < cols; x++)
+            total += column_error[x];
+        return total;
+    };
+    int best_dx = 0, best_dy = 0;
+    int64_t best = -1;
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            const int64_t error = shiftedError(dx, dy);
+            if (best < 0 || error < best) {
+                best = error;
+                best_dx = dx;
+                best_dy = dy;
+            }
+        }
+    }
+    shiftedError(best_dx, best_dy);
+    // Cửa sổ kThumbWindow cột (khoảng một ký tự ở chiều cao 48), bước nửa cửa sổ.
+    const int window = std::min(cols, kThumbWindow);
+    int64_t worst = 0;
+    for (int c0 = 0;; c0 = std::min(c0 + window / 2, cols - window)) {
+        int64_t sum = 0;
+        for (int x = c0; x < c0 + window; x++)
+            sum += column_error[x];
+        worst = std::max(worst, sum);
+        if (c0 + window >= cols)
+            break;
+    }
+    return static_cast<float>(worst) / (static_cast<float>(rows) * window * 255.f * 255.f);
+}
+
+RecFingerprint FingerprintRecInput(const float *input, int height, int width, int row_stride) {
+    return RecFingerprint{HashRecInput(input, height, width, row_stride),
+                          ThumbnailRecInput(input, height, width, row_stride)};
+}
+
+int HammingDistance(const PerceptualHash &a, const PerceptualHash &b) {
+    int distance = 0;
+    for (int i = 0; i < 4; i++)
+        distance += static_cast<int>(std::bitset<64>(a.bits[i] ^ b.bits[i]).count());
+    return distance;
+}
+
+RecCache::RecCache(size_t capacity, int max_distance)
+    : capacity_(capacity), max_distance_(std::max(0, max_distance)) {}
+
+uint64_t RecCache::BucketKey(uint64_t variant, int width) {
+    const uint64_t bucket = static_cast<uint64_t>(width / kWidthStep);
+    return variant ^ (bucket * 0x9E3779B97F4A7C15ull);
+}
+
+bool RecCache::sameContent(const RecFingerprint &a, const RecFingerprint &b, int distance) const {
+    return distance <= max_distance_ && ThumbnailDistance(a.thumbnail, b.thumbnail) <= kMaxThumbnailDistance;
+}
+
+RecCache::EntryList::iterator RecCache::nearest(uint64_t key, const RecFingerprint &fingerprint) {
+    auto bucket = buckets_.find(key);
+    if (bucket == buckets_.end())
+        return entries_.end();
+    EntryList::iterator best = entries_.end();
+    int best_distance = max_distance_ + 1;
+    for (EntryList::iterator it : bucket->second) {
+        const int distance = HammingDistance(it->fingerprint.hash, fingerprint.hash);
+        // Ảnh thu nhỏ chỉ được so với ứng viên gần hơn ứng viên tốt nhất hiện có.
+        if (distance < best_distance && sameContent(it->fingerprint, fingerprint, distance)) {
+            best_distance = distance;
+            best = it;
+            if (distance == 0)
+                break;
+        }
+    }
+    return best;
+}
+
+bool RecCache::find(uint64_t variant, int width, const RecFingerprint &fingerprint, DecodeResult &result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = nearest(BucketKey(variant, width), fingerprint);
+    if (it == entries_.end())
+        return false;
+    entries_.splice(entries_.begin(), entries_, it);
+    result = it->result;
+    return true;
+}
+
+void RecCache::insert(uint64_t variant, int width, const RecFingerprint &fingerprint, const DecodeResult &result) {
+    if (capacity_ == 0)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint64_t key = BucketKey(variant, width);
+    auto it = nearest(key, fingerprint);
+    if (it != entries_.end()) {
+        it->fingerprint = fingerprint;
+        it->result = result;
+        entries_.splice(entries_.begin(), entries_, it);
+        return;
+    }
+    if (entries_.size() >= capacity_) {
+        // Bỏ mục dùng lâu nhất khỏi bucket của nó (đổi chỗ với phần tử cuối rồi xóa).
+        auto oldest = std::prev(entries_.end());
+        auto bucket = buckets_.find(oldest->key);
+        std::vector<EntryList::iterator> &list = bucket->second;
+        *std::find(list.begin(), list.end(), oldest) = list.back();
+        list.pop_back();
+        if (list.empty())
+            buckets_.erase(bucket);
+        entries_.pop_back();
+    }
+    entries_.push_front(Entry{key, fingerprint, result});
+    buckets_[key].push_back(entries_.begin());
+}
+
+bool RecCache::matches(int width_a, const RecFingerprint &a, int width_b, const RecFingerprint &b) const {
+    return width_a / kWidthStep == width_b / kWidthStep && sameContent(a, b, HammingDistance(a.hash, b.hash));
+}
+
+void RecCache::addStats(uint64_t hits, uint64_t misses) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hits_ += hits;
+    misses_ += misses;
+}
+
+RecCacheStats RecCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    RecCacheStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.size = entries_.size();
+    return stats;
+}
+
+void RecCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    buckets_.clear();
+    hits_ = 0;
+    misses_ = 0;
+}
+
+} // namespace ocr
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "ctc_decoder.h"
+
+namespace ocr {
+
+// Hash cảm nhận (difference hash) 256 bit của input recognition đã chuẩn hóa: độ sáng trung bình ba kênh
+// được lấy trung bình theo lưới 8 hàng x 33 cột, mỗi bit là dấu của chênh lệch giữa hai ô liền nhau theo
+// chiều ngang (ô sáng hơn ô bên phải một khoảng đáng kể so với tương phản của crop). Không đổi khi độ
+// sáng / tương phản thay đổi đều, và chỉ đổi vài bit khi ảnh lệch nhẹ hoặc nhiễu, nên các crop của cùng
+// một nội dung có khoảng cách Hamming nhỏ.
+struct PerceptualHash {
+    uint64_t bits[4];
+};
+
+// Hash của tensor input (3 x height x width, mỗi kênh height x row_stride).
+PerceptualHash HashRecInput(const float *input, int height, int width, int row_stride);
+
+// Số bit khác nhau giữa hai hash.
+int HammingDistance(const PerceptualHash &a, const PerceptualHash &b);
+
+// Ảnh thu nhỏ xám của input recognition đã chuẩn hóa (8 bit, kéo giãn theo min / max của chính crop, làm
+// mờ 3x3), mỗi ô khoảng 3 x 3 pixel input: kThumbRows hàng, số cột chỉ phụ thuộc bucket chiều rộng
+// (RecCache::kWidthStep) nên hai crop cùng bucket so được từng ô. Dùng để xác nhận rằng hai crop có hash
+// gần nhau thật sự cùng nội dung: hash chỉ giữ dấu chênh lệch giữa các ô lớn nên hai dòng khác nhau một ký
+// tự có thể chỉ cách nhau vài bit.
+struct RecThumbnail {
+    static constexpr int kThumbRows = 16;
+    int cols = 0;
+    std::vector<uint8_t> pixels;  // kThumbRows x cols
+};
+
+// Ảnh thu nhỏ của tensor input (cùng layout với HashRecInput).
+RecThumbnail ThumbnailRecInput(const float *input, int height, int width, int row_stride);
+
+// Độ lệch giữa hai ảnh thu nhỏ cùng số cột, theo thang [0, 1]: sau khi dịch b tối đa một ô mỗi chiều cho
+// khớp nhất, trung bình bình phương chênh lệch lớn nhất trên các cửa sổ rộng khoảng một ký tự (nên một ký
+// tự khác nhau không bị pha loãng theo chiều dài dòng). 1 nếu số cột khác nhau.
+float ThumbnailDistance(const RecThumbnail &a, const RecThumbnail &b);
+
+// Dấu vân tay của một crop trong cache: hash để tìm nhanh, ảnh thu nhỏ để xác nhận.
+struct RecFingerprint {
+    PerceptualHash hash;
+    RecThumbnail thumbnail;
+};
+
+// Tính cả hash lẫn ảnh thu nhỏ của tensor input.
+RecFingerprint FingerprintRecInput(const float *input, int height, int width, int row_stride);
+
+struct RecCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t size = 0;
+};
+
+// Cache kết quả recognition có giới hạn (LRU), khóa là hash cảm nhận của crop đã chuẩn hóa cùng bucket
+// chiều rộng input của nó và biến thể decode (decoder, từ vựng, mẫu): crop có cùng bucket và biến thể,
+// hash cách một mục đã lưu không quá max_distance bit và ảnh thu nhỏ lệch không quá kMaxThumbnailDistance dùng
+// lại kết quả của mục đó (hash chỉ để tìm ứng viên, không mục nào được dùng lại chỉ nhờ hash). An toàn khi
+// gọi từ nhiều luồng (dùng chung giữa các recognizer của RecPool).
+class RecCache {
+public:
+    // Bước chiều rộng input (pixel, tại chiều cao 48) của một bucket.
+    static constexpr int kWidthStep = 16;
+    // Ngưỡng ThumbnailDistance để hai crop được coi là cùng nội dung.
+    static constexpr float kMaxThumbnailDistance = 0.016f;
+
+    RecCache(size_t capacity, int max_distance);
+
+    // Tìm mục gần nhất (trong max_distance, đã xác nhận bằng ảnh thu nhỏ) và đưa nó lên đầu LRU; false nếu
+    // không có.
+    bool find(uint64_t variant, int width, const RecFingerprint &fingerprint, DecodeResult &result);
+    // Thêm kết quả (thay mục gần nhất nếu đã có), bỏ mục dùng lâu nhất khi đầy.
+    void insert(uint64_t variant, int width, const RecFingerprint &fingerprint, const DecodeResult &result);
+    // Hai crop (chiều rộng input, dấu vân tay) có được coi là cùng nội dung không (cùng bucket, hash đủ gần,
+    // ảnh thu nhỏ khớp).
+    bool matches(int width_a, const RecFingerprint &a, int width_b, const RecFingerprint &b) const;
+    // Cộng dồn bộ đếm trúng / trượt (một lần cho mỗi lượt recognizeBatch).
+    void addStats(uint64_t hits, uint64_t misses);
+
+    RecCacheStats stats() const;
+    size_t capacity() const { return capacity_; }
+    void clear();
+
+private:
+    struct Entry {
+        uint64_t key;
+        RecFingerprint fingerprint;
+        DecodeResult result;
+    };
+    using EntryList = std::list<Entry>;
+
+    // Khóa bucket: biến thể decode kết hợp bucket chiều rộng.
+    static uint64_t BucketKey(uint64_t variant, int width);
+    // Hash trong max_distance_ và ảnh thu nhỏ khớp.
+    bool sameContent(const RecFingerprint &a, const RecFingerprint &b, int distance) const;
+    // Mục gần nhất trong bucket key đã xác nhận cùng nội dung, end() nếu không có. Gọi khi đang giữ mutex_.
+    EntryList::iterator nearest(uint64_t key, const RecFingerprint &fingerprint);
+
+    size_t capacity_;
+    int max_distance_;
+    mutable std::mutex mutex_;
+    // Đầu danh sách là mục vừa dùng.
+    EntryList entries_;
+    std::unordered_map<uint64_t, std::vector<EntryList::iterator>> buckets_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+} // namespace ocr
@@ -0,0 +1,95 @@
+#include "rec_cascade.h"
+#include <chrono>
+#include <iostream>
+
+namespace ocr {
+
+RecCascade::RecCascade(const std::string &small_model_path, const std::string &large_model_path,
+                       const std::string &char_dict_path, int pool_size, int threads_per_predictor)
+    : small_(small_model_path, char_dict_path, pool_size, threads_per_predictor),
+      large_(large_model_path, char_dict_path, pool_size, threads_per_predictor) {}
+
+std::vector<DecodeResult> RecCascade::recognizeAll(const std::vector<RecCrop> &crops,
+                                                   const std::map<std::string, double> &config,
+                                                   const std::string &format) {
+    auto it = config.find("cascade_threshold");
+    const float threshold = static_cast<float>(it == config.end() ? 0.85 : it->second);
+    std::shared_ptr<const PatternDfa> dfa;
+    if (!format.empty()) {
+        std::string error;
+        dfa = small_.compilePattern(format, &error);
+        if (!dfa)
+            std::cerr << "Mẫu \"" << format << "\" không hợp lệ: " << error << std::endl;
+    }
+
+    auto small_start = std::chrono::steady_clock::now();
+    std::vector<DecodeResult> results = small_.recognizeAll(crops, config);
+    double small_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - small_start).count();
+
+    // Crop cần chạy lại: confidence thấp hoặc sai định dạng (crop rỗng không có gì để chạy lại).
+    std::vector<RecCrop> doubtful;
+    std::vector<size_t> indices;
+    std::vector<char> small_matches;
+    uint64_t non_empty = 0;
+    for (size_t i = 0; i < crops.size(); i++) {
+        if (RecProcess::InputWidth(crops[i]) <= 0)
+            continue;
+        non_empty++;
+        const DecodeResult &result = results[i];
+        const bool matches = !dfa || small_.matchesPattern(result.text, *dfa);
+        if (result.confidence < threshold || !matches) {
+            doubtful.push_back(crops[i]);
+            indices.push_back(i);
+            small_matches.push_back(matches);
+        }
+    }
+
+    double large_ms = 0.0;
+    if (!doubtful.empty()) {
+        auto large_start = std::chrono::steady_clock::now();
+        std::vector<DecodeResult> large_results = large_.recognizeAll(doubtful, config);
+        large_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - large_start).count();
+        // Mô hình lớn không phải lúc nào cũng đúng hơn: kết quả khớp mẫu thắng, cùng khớp (hoặc cùng không)
+        // thì lấy confidence cao hơn.
+        for (size_t k = 0; k < indices.size(); k++) {
+            DecodeResult &large = large_results[k];
+            const bool large_matches = !dfa || large_.matchesPattern(large.text, *dfa);
+            const bool take_large = large_matches != static_cast<bool>(small_matches[k])
+                                        ? large_matches
+                                        : large.confidence > results[indices[k]].confidence;
+            if (take_large)
+                results[indices[k]] = std::move(large);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.crops += non_empty;
+    stats_.escalated += doubtful.size();
+    stats_.small_ms += small_ms;
+    stats_.large_ms += large_ms;
+    return results;
+}
+
+void RecCascade::warmUp(int max_batch) {
+    small_.warmUp(max_batch);
+    large_.warmUp(max_batch);
+}
+
+void RecCascade::warmUp(const std::vector<std::pair<int, int>> &shapes) {
+    small_.warmUp(shapes);
+    large_.warmUp(shapes);
+}
+
+RecCascadeStats RecCascade::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void RecCascade::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = RecCascadeStats{};
+}
+
+} // namespace ocr
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "rec_pool.h"
+
+namespace ocr {
+
+// Thống kê cộng dồn của RecCascade: số crop không rỗng, số crop phải chạy lại trên mô hình lớn, và thời
+// gian (ms, đồng hồ thực) của mỗi tầng.
+struct RecCascadeStats {
+    uint64_t crops = 0;
+    uint64_t escalated = 0;
+    double small_ms = 0.0;
+    double large_ms = 0.0;
+};
+
+// Nhận dạng hai tầng: mọi crop chạy trên mô hình nhỏ (nhanh) trước, chỉ crop có confidence dưới
+// ngưỡng hoặc không khớp mẫu định dạng mới được chạy lại trên mô hình lớn (chính xác hơn), nên với
+// phần lớn crop dễ, chi phí gần như của mô hình nhỏ. Hai mô hình phải dùng cùng từ điển ký tự.
+// Mỗi tầng là một RecPool (nhận dạng song song, bucket, warm-up, cache như RecPool).
+class RecCascade {
+public:
+    RecCascade(const std::string &small_model_path, const std::string &large_model_path,
+               const std::string &char_dict_path, int pool_size, int threads_per_predictor = 1);
+
+    RecCascade(const RecCascade &) = delete;
+    RecCascade &operator=(const RecCascade &) = delete;
+
+    // Nhận dạng như RecPool::recognizeAll trên mô hình nhỏ; crop có confidence
+    // < config["cascade_threshold"] (mặc định 0.85) hoặc, khi format khác rỗng, text không khớp toàn bộ
+    // mẫu format (cú pháp của PatternDfa) được nhận dạng lại trên mô hình lớn. Giữ kết quả khớp mẫu nếu chỉ
+    // một trong hai khớp, ngược lại kết quả có confidence cao hơn. Mẫu được biên dịch một lần mỗi lượt;
+    // mẫu sai cú pháp được báo ra stderr và bỏ qua (chỉ xét confidence).
+    // Kết quả theo đúng thứ tự đầu vào.
+    std::vector<DecodeResult> recognizeAll(const std::vector<RecCrop> &crops,
+                                           const std::map<std::string, double> &config,
+                                           const std::string &format = "");
+
+    // Warm-up cả hai tầng (xem RecPool::warmUp).
+    void warmUp(int max_batch);
+    void warmUp(const std::vector<std::pair<int, int>> &shapes);
+
+    RecCascadeStats stats() const;
+    void resetStats();
+
+    RecPool &smallPool() { return small_; }
+    RecPool &largePool() { return large_; }
+
+private:
+    RecPool small_;
+    RecPool large_;
+    mutable std::mutex mutex_;
+    RecCascadeStats stats_;
+};
+
+} // namespace ocr
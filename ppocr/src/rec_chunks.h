@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace ocr {
+
+// Chia dòng của RecProcess::recognizeBatch thành các đoạn và ghép lại output của chúng. Piece là đoạn có
+// offset (cột bắt đầu trên input của cả dòng), width (chiều rộng input) và step_width (số cột input của một
+// bước output); Steps là CtcPath, CtcLattice hoặc KeywordFrames (size, isBlank, appendStep).
+
+// Cột bắt đầu của các đoạn rộng chunk_width chồng lấn ít nhất overlap cột, đặt đều từ mép trái đến mép phải
+// của dòng rộng width (> chunk_width).
+inline std::vector<int> ChunkOffsets(int width, int chunk_width, int overlap) {
+    const int stride = std::max(1, chunk_width - overlap);
+    const int count = 1 + (width - chunk_width + stride - 1) / stride;
+    const double step = static_cast<double>(width - chunk_width) / (count - 1);
+    std::vector<int> offsets(count);
+    for (int k = 0; k < count; k++)
+        offsets[k] = static_cast<int>(std::lround(k * step));
+    return offsets;
+}
+
+// Chỗ nối hai đoạn liên tiếp left, right (a, b là các bước của chúng): a giữ các bước [0, a_end), b giữ các
+// bước [b_begin, b.size()). Căn chỉnh của hai đoạn trên vùng chồng lấn có thể lệch nhau vài bước (mỗi đoạn
+// thấy ngữ cảnh khác nhau), nên trước hết tìm độ lệch (trong kMaxJoinShift bước) mà các bước khác blank
+// của hai đoạn trùng nhau nhiều nhất; rồi nối tại bước gần điểm giữa vùng chồng lấn nhất mà cả a lẫn bước
+// tương ứng của b đều blank. Không ký tự nào nằm vắt qua chỗ nối đó nên không ký tự nào bị lấy hai lần hay
+// bị mất. Không có bước như vậy thì nối tại bước gần điểm giữa nhất theo cùng độ lệch.
+template <typename Piece, typename Steps>
+void FindChunkJoin(const Piece &left, const Steps &a, const Piece &right, const Steps &b, size_t &a_end,
+                   size_t &b_begin) {
+    const int kMaxJoinShift = 2;
+    const float mid = 0.5f * (right.offset + left.offset + left.width);
+    // Bước của b ứng với bước t của a (cùng tâm) khi lệch shift bước; -1 nếu ngoài b.
+    auto aligned = [&](size_t t, int shift) {
+        const float center = left.offset + (t + 0.5f) * left.step_width;
+        const int u = static_cast<int>(std::floor((center - right.offset) / right.step_width)) + shift;
+        return u >= 0 && u < static_cast<int>(b.size()) ? u : -1;
+    };
+    int best_shift = 0, best_agree = -1;
+    for (int shift : {0, -1, 1, -2, 2}) {
+        if (std::abs(shift) > kMaxJoinShift)
+            continue;
+        int agree = 0;
+        for (size_t t = 0; t < a.size(); t++) {
+            const int u = aligned(t, shift);
+            if (u >= 0 && !a.isBlank(t) && !b.isBlank(u))
+                agree++;
+        }
+        if (agree > best_agree) {
+            best_agree = agree;
+            best_shift = shift;
+        }
+    }
+    float best = 1e30f;
+    bool best_blank = false;
+    a_end = a.size();
+    b_begin = b.size();
+    for (size_t t = 0; t < a.size(); t++) {
+        const int u = aligned(t, best_shift);
+        if (u < 0)
+            continue;
+        const bool blank = a.isBlank(t) && b.isBlank(u);
+        const float distance = std::abs(left.offset + (t + 1.f) * left.step_width - mid);
+        if ((blank && !best_blank) || (blank == best_blank && distance < best)) {
+            best = distance;
+            best_blank = blank;
+            a_end = t + 1;
+            b_begin = u + 1;
+        }
+    }
+}
+
+// Ghép các bước thời gian (đường argmax, lattice hoặc frame từ khóa) của các đoạn liên tiếp
+// pieces[begin, end) của cùng một crop tại chỗ nối của từng cặp đoạn liền nhau (FindChunkJoin); lớp lặp ở
+// chỗ nối được gộp bởi CTC như thường.
+template <typename Piece, typename Steps>
+Steps StitchChunks(const std::vector<Piece> &pieces, const std::vector<Steps> &parts, size_t begin, size_t end) {
+    Steps stitched;
+    size_t first = 0;
+    for (size_t k = begin; k < end; k++) {
+        const Steps &part = parts[k];
+        size_t last = part.size(), next_first = 0;
+        if (k + 1 < end)
+            FindChunkJoin(pieces[k], part, pieces[k + 1], parts[k + 1], last, next_first);
+        for (size_t t = first; t < last; t++)
+            stitched.appendStep(part, t);
+        first = next_first;
+    }
+    return stitched;
+}
+
+} // namespace ocr
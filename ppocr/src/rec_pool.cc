@@ -0,0 +1,170 @@
+#include "rec_pool.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <iostream>
+
+namespace ocr {
+
+RecPool::RecPool(const std::string &model_path, const std::string &char_dict_path,
+                 int pool_size, int threads_per_predictor) {
+    pool_size = std::max(1, pool_size);
+    // Chỉ recognizer đầu tiên đọc file mô hình, các recognizer còn lại clone từ nó.
+    recognizers_.emplace_back(new RecProcess(model_path, char_dict_path, threads_per_predictor));
+    for (int i = 1; i < pool_size; i++)
+        recognizers_.push_back(recognizers_.front()->clone());
+    for (auto &rec : recognizers_)
+        idle_.push_back(rec.get());
+    workers_.reset(new ThreadPool(pool_size - 1));
+}
+
+RecPool::~RecPool() = default;
+
+RecPool::Lease::Lease(Lease &&other) noexcept : pool_(other.pool_), rec_(other.rec_) {
+    other.pool_ = nullptr;
+    other.rec_ = nullptr;
+}
+
+RecPool::Lease::~Lease() {
+    if (pool_)
+        pool_->release(rec_);
+}
+
+RecPool::Lease RecPool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !idle_.empty(); });
+    RecProcess *rec = idle_.back();
+    idle_.pop_back();
+    return Lease(this, rec);
+}
+
+void RecPool::release(RecProcess *rec) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(rec);
+    }
+    cv_.notify_one();
+}
+
+int RecPool::size() const {
+    return static_cast<int>(recognizers_.size());
+}
+
+void RecPool::runGroups(const std::vector<RecCrop> &crops, const std::map<std::string, double> &config,
+                        const std::function<void(RecProcess &, const std::vector<RecCrop> &,
+                                                 const std::vector<size_t> &)> &work) {
+    if (crops.empty())
+        return;
+
+    // Sắp theo chiều rộng để mỗi nhóm rơi vào ít bucket nhất.
+    std::vector<int> widths(crops.size());
+    std::vector<size_t> order(crops.size());
+    for (size_t i = 0; i < crops.size(); i++) {
+        widths[i] = RecProcess::InputWidth(crops[i]);
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return widths[a] < widths[b]; });
+
+    auto it = config.find("rec_batch_size");
+    size_t batch = static_cast<size_t>(std::max(1.0, it == config.end() ? 8.0 : it->second));
+    // Ít dòng thì chia nhỏ nhóm để mọi recognizer đều có việc.
+    batch = std::min(batch, (crops.size() + recognizers_.size() - 1) / recognizers_.size());
+    const int groups = static_cast<int>((crops.size() + batch - 1) / batch);
+
+    workers_->parallelFor(groups, [&](int g, int) {
+        size_t begin = g * batch, end = std::min(begin + batch, crops.size());
+        std::vector<RecCrop> group;
+        std::vector<size_t> indices(order.begin() + begin, order.begin() + end);
+        group.reserve(indices.size());
+        for (size_t index : indices)
+            group.push_back(crops[index]);
+        Lease rec = acquire();
+        work(*rec, group, indices);
+    });
+}
+
+std::vector<DecodeResult> RecPool::recognizeAll(const std::vector<RecCrop> &crops,
+                                                const std::map<std::string, double> &config,
+                                                const std::string &pattern) {
+    std::vector<DecodeResult> results(crops.size(), DecodeResult{"", 0.f});
+    runGroups(crops, config, [&](RecProcess &rec, const std::vector<RecCrop> &group,
+                                 const std::vector<size_t> &indices) {
+        std::vector<DecodeResult> group_results = rec.recognizeBatch(group, config, pattern);
+        for (size_t k = 0; k < indices.size(); k++)
+            results[indices[k]] = std::move(group_results[k]);
+    });
+    return results;
+}
+
+std::vector<KeywordHit> RecPool::spotKeywords(const std::vector<RecCrop> &crops, const KeywordSet &keywords,
+                                              const std::map<std::string, double> &config) {
+    std::vector<KeywordHit> hits;
+    std::mutex hits_mutex;
+    runGroups(crops, config, [&](RecProcess &rec, const std::vector<RecCrop> &group,
+                                 const std::vector<size_t> &indices) {
+        std::vector<KeywordHit> group_hits = rec.spotKeywords(group, keywords, config);
+        std::lock_guard<std::mutex> lock(hits_mutex);
+        for (KeywordHit &hit : group_hits) {
+            hit.crop = indices[hit.crop];
+            hits.push_back(hit);
+        }
+    });
+    std::stable_sort(hits.begin(), hits.end(), [](const KeywordHit &a, const KeywordHit &b) {
+        return a.crop != b.crop ? a.crop < b.crop : a.keyword < b.keyword;
+    });
+    return hits;
+}
+
+std::shared_ptr<const KeywordSet> RecPool::compileKeywords(const std::vector<std::string> &keywords) const {
+    return recognizers_.front()->compileKeywords(keywords);
+}
+
+bool RecPool::matchesPattern(const std::string &text, const std::string &pattern) const {
+    return recognizers_.front()->matchesPattern(text, pattern);
+}
+
+bool RecPool::matchesPattern(const std::string &text, const PatternDfa &dfa) const {
+    return recognizers_.front()->matchesPattern(text, dfa);
+}
+
+std::shared_ptr<const PatternDfa> RecPool::compilePattern(const std::string &pattern, std::string *error) const {
+    return recognizers_.front()->compilePattern(pattern, error);
+}
+
+void RecPool::warmUp(int max_batch) {
+    // Mỗi index đúng một recognizer (không qua acquire, một recognizer vừa trả về có thể bị mượn lại).
+    workers_->parallelFor(size(), [&](int i, int) { recognizers_[i]->warmUp(max_batch); });
+}
+
+void RecPool::warmUp(const std::vector<std::pair<int, int>> &shapes) {
+    workers_->parallelFor(size(), [&](int i, int) { recognizers_[i]->warmUp(shapes); });
+}
+
+int RecPool::loadLexicon(const std::string &trie_path) {
+    // Map một lần, mọi recognizer dùng chung; id giống nhau vì các recognizer đăng ký theo cùng thứ tự.
+    auto lexicon = LexiconTrie::Open(trie_path);
+    if (!lexicon) {
+        std::cerr << "Không mở được file trie từ vựng " << trie_path << std::endl;
+        return 0;
+    }
+    int id = 0;
+    for (auto &rec : recognizers_)
+        id = rec->addLexicon(lexicon);
+    return id;
+}
+
+void RecPool::enableCache(size_t capacity, int max_distance) {
+    std::shared_ptr<RecCache> cache = capacity > 0 ? std::make_shared<RecCache>(capacity, max_distance) : nullptr;
+    for (auto &rec : recognizers_)
+        rec->setCache(cache);
+}
+
+RecCacheStats RecPool::cacheStats() const {
+    return recognizers_.front()->cacheStats();
+}
+
+void RecPool::setWidthBuckets(const std::vector<int> &widths) {
+    for (auto &rec : recognizers_)
+        rec->setWidthBuckets(widths);
+}
+
+} // namespace ocr
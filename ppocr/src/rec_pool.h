@@ -0,0 +1,111 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "rec_process.h"
+
+namespace ocr {
+
+class ThreadPool;
+
+// Pool recognizer cho nhận dạng song song: mô hình .nb chỉ được load một lần, các RecProcess còn lại
+// là bản clone dùng chung trọng số (RecProcess::clone). Mỗi recognizer có predictor và tensor input
+// riêng nên nhiều luồng có thể nhận dạng cùng lúc, miễn là mỗi luồng giữ một Lease.
+class RecPool {
+public:
+    // pool_size: số recognizer (số lần Run() đồng thời tối đa).
+    // threads_per_predictor: số luồng Paddle Lite của mỗi predictor.
+    RecPool(const std::string &model_path, const std::string &char_dict_path,
+            int pool_size, int threads_per_predictor = 1);
+    ~RecPool();
+
+    RecPool(const RecPool &) = delete;
+    RecPool &operator=(const RecPool &) = delete;
+
+    // Quyền dùng riêng một recognizer, tự trả về pool khi bị hủy.
+    class Lease {
+    public:
+        Lease(Lease &&other) noexcept;
+        ~Lease();
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        Lease &operator=(Lease &&) = delete;
+
+        RecProcess &operator*() const { return *rec_; }
+        RecProcess *operator->() const { return rec_; }
+
+    private:
+        friend class RecPool;
+        Lease(RecPool *pool, RecProcess *rec) : pool_(pool), rec_(rec) {}
+        RecPool *pool_;
+        RecProcess *rec_;
+    };
+
+    // Mượn một recognizer rảnh, chờ nếu tất cả đang bận. An toàn khi gọi từ nhiều luồng.
+    Lease acquire();
+
+    // Số recognizer trong pool.
+    int size() const;
+
+    // Nhận dạng song song: các crop được sắp theo chiều rộng input rồi chia thành nhóm liền nhau
+    // (tối đa config["rec_batch_size"] crop, mặc định 8, nhỏ hơn nếu không đủ việc cho mọi recognizer),
+    // mỗi nhóm chạy recognizeBatch trên một recognizer của pool. Kết quả theo đúng thứ tự đầu vào.
+    // pattern: mẫu định dạng cho mọi crop (xem RecProcess::recognizeBatch).
+    std::vector<DecodeResult> recognizeAll(const std::vector<RecCrop> &crops,
+                                           const std::map<std::string, double> &config,
+                                           const std::string &pattern = "");
+
+    // Dò từ khóa song song (RecProcess::spotKeywords) với cùng cách chia nhóm như recognizeAll;
+    // kết quả theo thứ tự crop, KeywordHit::crop là chỉ số trong crops.
+    std::vector<KeywordHit> spotKeywords(const std::vector<RecCrop> &crops, const KeywordSet &keywords,
+                                         const std::map<std::string, double> &config);
+
+    // Tập từ khóa theo từ điển ký tự của mô hình (xem RecProcess::compileKeywords).
+    std::shared_ptr<const KeywordSet> compileKeywords(const std::vector<std::string> &keywords) const;
+
+    // Text có khớp toàn bộ mẫu định dạng không (xem RecProcess::matchesPattern).
+    bool matchesPattern(const std::string &text, const std::string &pattern) const;
+    bool matchesPattern(const std::string &text, const PatternDfa &dfa) const;
+    // DFA của mẫu định dạng (xem RecProcess::compilePattern).
+    std::shared_ptr<const PatternDfa> compilePattern(const std::string &pattern, std::string *error = nullptr) const;
+
+    // Warm-up mọi recognizer (RecProcess::warmUp) song song, gọi một lần sau khi khởi tạo
+    // (khi không có Lease nào đang được giữ).
+    void warmUp(int max_batch);
+    void warmUp(const std::vector<std::pair<int, int>> &shapes);
+
+    // Map file trie từ vựng một lần và đăng ký cho mọi recognizer (xem RecProcess::loadLexicon); trả về id
+    // dùng cho config["rec_lexicon"], 0 nếu lỗi. Chỉ gọi khi không có Lease nào đang được giữ.
+    int loadLexicon(const std::string &trie_path);
+
+    // Bật một cache kết quả dùng chung cho mọi recognizer (xem RecProcess::enableCache), capacity 0 tắt.
+    // Chỉ gọi khi không có Lease nào đang được giữ.
+    void enableCache(size_t capacity, int max_distance = 8);
+    // Bộ đếm trúng / trượt của cache dùng chung.
+    RecCacheStats cacheStats() const;
+
+    // Thiết lập bucket chiều rộng cho mọi recognizer (xem RecProcess::setWidthBuckets).
+    // Chỉ gọi khi không có Lease nào đang được giữ.
+    void setWidthBuckets(const std::vector<int> &widths);
+
+private:
+    void release(RecProcess *rec);
+    // Sắp crops theo chiều rộng input, chia thành các nhóm liền nhau và chạy work(recognizer, nhóm, chỉ số
+    // gốc của từng crop trong nhóm) song song, mỗi nhóm trên một recognizer mượn từ pool.
+    void runGroups(const std::vector<RecCrop> &crops, const std::map<std::string, double> &config,
+                   const std::function<void(RecProcess &, const std::vector<RecCrop> &,
+                                            const std::vector<size_t> &)> &work);
+
+    std::vector<std::unique_ptr<RecProcess>> recognizers_;
+    std::vector<RecProcess *> idle_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    // Luồng chạy recognizeAll (size() - 1 worker, luồng gọi cũng tham gia).
+    std::unique_ptr<ThreadPool> workers_;
+};
+
+} // namespace ocr
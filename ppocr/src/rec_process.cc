@@ -1,8 +1,13 @@
 #include "rec_process.h"
+#include "rec_chunks.h"
+#include "text_crop.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <fstream>
 #include <sstream>
-#include <cstring>
-#include <opencv2/imgproc.hpp>
+#include <unordered_map>
 #include <iostream>
 #include <cmath>
 
@@ -10,18 +15,117 @@ namespace ocr {
 
 using namespace paddle::lite_api;
 
-RecProcess::RecProcess(const std::string &model_path, const std::string &char_dict_path) {
+// Một phần của crop được đưa vào predictor: cả crop, hoặc một đoạn của dòng quá rộng.
+struct RecPiece {
+    RecCrop crop;
+    int width;          // chiều rộng input của đoạn (tại chiều cao 48)
+    size_t owner;       // chỉ số crop gốc
+    int offset;         // cột bắt đầu của đoạn trên input của crop gốc
+    float step_width;   // số cột input ứng với một bước thời gian của output
+    const float *input; // input đã crop + chuẩn hóa sẵn (3 x 48 x width, liền nhau), nullptr nếu chưa có
+};
+
+namespace {
+
+// Đọc khóa tùy chọn trong config, trả về giá trị mặc định nếu không có.
+double ConfigOr(const std::map<std::string, double> &config, const std::string &key, double def) {
+    auto it = config.find(key);
+    return it == config.end() ? def : it->second;
+}
+
+// Chia crop có chiều rộng input width thành các đoạn rộng chunk_width chồng lấn ít nhất overlap cột,
+// đặt đều từ mép trái đến mép phải. Đoạn của ảnh đã crop sẵn là vùng con của ảnh, giữ trong rois.
+void SplitIntoChunks(const RecCrop &crop, size_t owner, int width, int chunk_width, int overlap,
+                     std::vector<RecPiece> &pieces, std::deque<cv::Mat> &rois) {
+    for (int offset : ChunkOffsets(width, chunk_width, overlap)) {
+        const float t0 = static_cast<float>(offset) / width;
+        const float t1 = static_cast<float>(offset + chunk_width) / width;
+        RecPiece piece{crop, chunk_width, owner, offset, 0.f, nullptr};
+        if (crop.whole_image) {
+            const cv::Mat &src = *crop.source;
+            int x0 = static_cast<int>(std::floor(t0 * src.cols));
+            int x1 = std::min(src.cols, static_cast<int>(std::ceil(t1 * src.cols)));
+            rois.push_back(src(cv::Range::all(), cv::Range(x0, std::max(x1, x0 + 1))));
+            piece.crop = RecCrop(rois.back());
+        } else {
+            piece.crop.box = SubQuad(crop.box, t0, t1);
+        }
+        pieces.push_back(piece);
+    }
+}
+
+// Các đoạn đưa vào predictor cho crops: dòng có chiều rộng input lớn hơn config["rec_max_chunk_width"]
+// được chia thành các đoạn chồng lấn; các đoạn của một crop nằm liền nhau, crop rỗng không có đoạn nào.
+void SplitCrops(const std::vector<RecCrop> &crops, const std::map<std::string, double> &config,
+                std::vector<RecPiece> &pieces, std::deque<cv::Mat> &rois) {
+    const int max_chunk = static_cast<int>(ConfigOr(config, "rec_max_chunk_width", 960));
+    const int overlap = static_cast<int>(ConfigOr(config, "rec_chunk_overlap", 96));
+    pieces.reserve(crops.size());
+    for (size_t i = 0; i < crops.size(); i++) {
+        int width = RecProcess::InputWidth(crops[i]);
+        if (width <= 0)
+            continue;
+        if (max_chunk > 0 && width > max_chunk)
+            SplitIntoChunks(crops[i], i, width, max_chunk, std::min(overlap, max_chunk / 2), pieces, rois);
+        else
+            pieces.push_back(RecPiece{crops[i], width, i, 0, 0.f, nullptr});
+    }
+}
+
+// Số float tối đa của input đã chuẩn bị được giữ lại giữa bước tra cache và runPieces (32 MB).
+constexpr size_t kMaxKeptInput = static_cast<size_t>(8) << 20;
+
+// Batch chuẩn cho lô n phần tử: lũy thừa 2 nhỏ nhất >= n, không vượt max_batch.
+int CanonicalBatch(int n, int max_batch) {
+    int batch = 1;
+    while (batch < n)
+        batch *= 2;
+    return std::min(batch, max_batch);
+}
+
+// Đưa kết quả dùng lại (từ cache hoặc crop cùng nội dung) về crop có chiều rộng input width: hai crop chỉ
+// cùng bucket chiều rộng chứ không cùng chiều rộng, nội dung co giãn theo chiều rộng nên vị trí ký tự (theo
+// tỷ lệ) giữ nguyên, chỉ số cột input của một bước đổi theo.
+void RescaleToWidth(DecodeResult &result, int width) {
+    if (result.input_width > 0 && result.input_width != width)
+        result.step_width *= static_cast<float>(width) / result.input_width;
+    result.input_width = width;
+}
+
+} // namespace
+
+RecProcess::RecProcess(const std::string &model_path, const std::string &char_dict_path, int cpu_threads) {
     // Load từ điển ký tự
     char_list_ = loadCharDict(char_dict_path);
     if (char_list_.empty()) {
         std::cerr << "Không tải được từ điển ký tự từ " << char_dict_path << std::endl;
     }
+    char_index_ = std::make_shared<const CharListIndex>(char_list_);
     // Cấu hình Paddle Lite cho recognition
     MobileConfig config;
     config.set_model_from_file(model_path);
+    config.set_threads(std::max(1, cpu_threads));
     predictor_ = CreatePaddlePredictor<MobileConfig>(config);
 }
 
+std::unique_ptr<RecProcess> RecProcess::clone() const {
+    std::unique_ptr<RecProcess> copy(new RecProcess());
+    copy->char_list_ = char_list_;
+    copy->predictor_ = predictor_->Clone();
+    copy->bucket_widths_ = bucket_widths_;
+    copy->lexicons_ = lexicons_;
+    copy->patterns_ = patterns_;
+    copy->char_index_ = char_index_;
+    copy->cache_ = cache_;
+    return copy;
+}
+
+int RecProcess::InputWidth(const RecCrop &crop) {
+    if (!crop.source || crop.source->empty())
+        return 0;
+    return RecInputWidth(crop.whole_image ? crop.source->size() : CropSize(crop.box), kInputHeight);
+}
+
 std::vector<std::string> RecProcess::loadCharDict(const std::string &dict_path) {
     std::vector<std::string> char_list;
     std::ifstream infile(dict_path);
@@ -34,70 +138,403 @@ std::vector<std::string> RecProcess::loadCharDict(const std::string &dict_path)
     return char_list;
 }
 
-DecodeResult RecProcess::ctcGreedyDecoder(const float* probs, int seq_len, int num_classes, const std::vector<std::string>& char_list) {
-    DecodeResult result;
-    result.text = "";
-    float confidence_sum = 0.f;
-    int count = 0;
-    int prev_index = -1;
-    for (int i = 0; i < seq_len; ++i) {
-        int max_index = 0;
-        float max_val = probs[i * num_classes];
-        for (int j = 1; j < num_classes; j++) {
-            float val = probs[i * num_classes + j];
-            if (val > max_val) {
-                max_val = val;
-                max_index = j;
+int RecProcess::compileLexicon(const std::string &words_path, const std::string &trie_path) const {
+    std::ifstream infile(words_path);
+    if (!infile) {
+        std::cerr << "Không đọc được file từ vựng " << words_path << std::endl;
+        return -1;
+    }
+    std::vector<std::string> words;
+    std::string line;
+    while (std::getline(infile, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty())
+            words.push_back(line);
+    }
+    return LexiconTrie::Compile(words, char_list_, trie_path);
+}
+
+bool RecProcess::matchesPattern(const std::string &text, const std::string &pattern) const {
+    std::shared_ptr<const PatternDfa> dfa = patterns_->get(pattern, char_list_);
+    return dfa && matchesPattern(text, *dfa);
+}
+
+bool RecProcess::matchesPattern(const std::string &text, const PatternDfa &dfa) const {
+    std::vector<int> labels;
+    if (text.empty())
+        return dfa.accepting(dfa.start());
+    return char_index_->split(text, labels) && dfa.matches(labels);
+}
+
+std::shared_ptr<const PatternDfa> RecProcess::compilePattern(const std::string &pattern, std::string *error) const {
+    return patterns_->get(pattern, char_list_, error);
+}
+
+int RecProcess::loadLexicon(const std::string &trie_path) {
+    auto lexicon = LexiconTrie::Open(trie_path);
+    if (!lexicon) {
+        std::cerr << "Không mở được file trie từ vựng " << trie_path << std::endl;
+        return 0;
+    }
+    return addLexicon(std::move(lexicon));
+}
+
+int RecProcess::addLexicon(std::shared_ptr<const LexiconTrie> lexicon) {
+    if (!lexicon)
+        return 0;
+    lexicons_.push_back(std::move(lexicon));
+    return static_cast<int>(lexicons_.size());
+}
+
+void RecProcess::enableCache(size_t capacity, int max_distance) {
+    cache_ = capacity > 0 ? std::make_shared<RecCache>(capacity, max_distance) : nullptr;
+}
+
+void RecProcess::setCache(std::shared_ptr<RecCache> cache) {
+    cache_ = std::move(cache);
+}
+
+RecCacheStats RecProcess::cacheStats() const {
+    return cache_ ? cache_->stats() : RecCacheStats{};
+}
+
+DecodeResult RecProcess::recognize(const cv::Mat &img) {
+    // Giả sử ảnh đầu vào đã được crop chứa vùng chữ; chạy như một lô một phần tử để dùng chung
+    // shape chuẩn (bucket chiều rộng) và predictor đã warm-up của recognizeBatch.
+    return recognizeBatch({RecCrop(img)}, {}).front();
+}
+
+DecodeResult RecProcess::recognize(const cv::Mat &src, const Quad &box) {
+    return recognizeBatch({RecCrop(src, box)}, {}).front();
+}
+
+void RecProcess::fillInput(const RecCrop &crop, int width, float *dst, int row_stride) {
+    if (crop.whole_image)
+        ResizeToTensor(*crop.source, kInputHeight, width, dst, row_stride);
+    else
+        CropResizeToTensor(*crop.source, crop.box, kInputHeight, width, dst, row_stride);
+}
+
+int RecProcess::bucketWidth(int width) const {
+    auto it = std::lower_bound(bucket_widths_.begin(), bucket_widths_.end(), width);
+    if (it != bucket_widths_.end())
+        return *it;
+    // Dòng rộng hơn bucket lớn nhất: làm tròn lên bội số kWideWidthStep để số shape vẫn hữu hạn.
+    return (width + kWideWidthStep - 1) / kWideWidthStep * kWideWidthStep;
+}
+
+PaddlePredictor *RecProcess::predictorForShape(int batch, int width) {
+    const auto key = std::make_pair(batch, width);
+    // Shape trong các bucket (số lượng có hạn: bucket x các batch chuẩn) được giữ suốt đời recognizer, kể cả
+    // các shape đã warm-up.
+    if (!bucket_widths_.empty() && width <= bucket_widths_.back()) {
+        std::shared_ptr<PaddlePredictor> &predictor = batch_predictors_[key];
+        if (!predictor)
+            predictor = predictor_->Clone();
+        return predictor.get();
+    }
+    auto found = wide_predictor_index_.find(key);
+    if (found != wide_predictor_index_.end()) {
+        wide_predictors_.splice(wide_predictors_.begin(), wide_predictors_, found->second);
+        return found->second->second.get();
+    }
+    // Dòng rất rộng tạo shape mới theo bước kWideWidthStep: bỏ shape rộng dùng lâu nhất để số bản clone có hạn.
+    if (wide_predictors_.size() >= kMaxWidePredictors) {
+        wide_predictor_index_.erase(wide_predictors_.back().first);
+        wide_predictors_.pop_back();
+    }
+    wide_predictors_.emplace_front(key, predictor_->Clone());
+    wide_predictor_index_[key] = wide_predictors_.begin();
+    return wide_predictors_.front().second.get();
+}
+
+void RecProcess::setWidthBuckets(const std::vector<int> &widths) {
+    bucket_widths_.clear();
+    for (int w : widths) {
+        if (w > 0)
+            bucket_widths_.push_back(w);
+    }
+    std::sort(bucket_widths_.begin(), bucket_widths_.end());
+    bucket_widths_.erase(std::unique(bucket_widths_.begin(), bucket_widths_.end()), bucket_widths_.end());
+    batch_predictors_.clear();
+    wide_predictors_.clear();
+    wide_predictor_index_.clear();
+}
+
+void RecProcess::runPieces(std::vector<RecPiece> &pieces, size_t max_batch,
+                           const std::function<void(size_t, const float *, int, int, int)> &consume) {
+    // Sắp các đoạn theo chiều rộng input để đoạn cùng bucket nằm liền nhau.
+    std::vector<size_t> order(pieces.size());
+    for (size_t i = 0; i < pieces.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return pieces[a].width < pieces[b].width; });
+
+    for (size_t begin = 0; begin < order.size();) {
+        const int bucket = bucketWidth(pieces[order[begin]].width);
+        size_t end = begin + 1;
+        while (end < order.size() && end - begin < max_batch && bucketWidth(pieces[order[end]].width) == bucket)
+            end++;
+        const int n = static_cast<int>(end - begin);
+        // Lô lẻ được pad thêm phần tử rỗng lên batch chuẩn để số shape (và predictor) có hạn.
+        const int batch = CanonicalBatch(n, static_cast<int>(max_batch));
+
+        PaddlePredictor *predictor = predictorForShape(batch, bucket);
+        auto input_tensor = predictor->GetInput(0);
+        input_tensor->Resize({batch, 3, kInputHeight, bucket});
+        float *input_data = input_tensor->mutable_data<float>();
+        const size_t item_size = static_cast<size_t>(3) * kInputHeight * bucket;
+        // Phần pad bên phải mỗi crop và các phần tử pad của lô giữ giá trị 0.
+        std::memset(input_data, 0, item_size * batch * sizeof(float));
+        for (int k = 0; k < n; k++) {
+            const RecPiece &piece = pieces[order[begin + k]];
+            float *dst = input_data + item_size * k;
+            if (!piece.input) {
+                fillInput(piece.crop, piece.width, dst, bucket);
+                continue;
+            }
+            // Input đã được chuẩn bị khi tra cache: chỉ chép từng hàng vào lát của lô.
+            for (int row = 0; row < 3 * kInputHeight; row++)
+                std::memcpy(dst + static_cast<size_t>(row) * bucket, piece.input + static_cast<size_t>(row) * piece.width,
+                            piece.width * sizeof(float));
+        }
+
+        predictor->Run();
+        auto output_tensor = predictor->GetOutput(0);
+        auto output_shape = output_tensor->shape(); // [N, seq_len, num_classes]
+        int seq_len = output_shape[1];
+        int num_classes = output_shape[2];
+        const float *output_data = output_tensor->data<float>();
+        for (int k = 0; k < n; k++) {
+            RecPiece &piece = pieces[order[begin + k]];
+            // Chỉ lấy các bước thời gian thuộc phần ảnh thật, bỏ phần pad.
+            int steps = std::min(seq_len, (seq_len * piece.width + bucket - 1) / bucket);
+            piece.step_width = static_cast<float>(bucket) / seq_len;
+            // Bước thời gian được đánh số trên cả dòng (đoạn bắt đầu ở cột offset của dòng).
+            const int first_step = static_cast<int>(std::lround(piece.offset / piece.step_width));
+            consume(order[begin + k], output_data + static_cast<size_t>(k) * seq_len * num_classes, steps,
+                    num_classes, first_step);
+        }
+        begin = end;
+    }
+}
+
+std::vector<DecodeResult> RecProcess::recognizeBatch(const std::vector<RecCrop> &crops,
+                                                     const std::map<std::string, double> &config,
+                                                     const std::string &pattern) {
+    const size_t max_batch = static_cast<size_t>(std::max(1.0, ConfigOr(config, "rec_batch_size", 8)));
+    const int lexicon_id = static_cast<int>(ConfigOr(config, "rec_lexicon", 0));
+    const LexiconTrie *lexicon = lexicon_id > 0 && lexicon_id <= static_cast<int>(lexicons_.size())
+                                     ? lexicons_[lexicon_id - 1].get()
+                                     : nullptr;
+    const bool beam_search = lexicon || static_cast<int>(ConfigOr(config, "rec_decoder", 0)) == 1;
+    const int beam_width = static_cast<int>(std::max(1.0, ConfigOr(config, "rec_beam_width", 5)));
+    const float beam_min_prob = static_cast<float>(ConfigOr(config, "rec_beam_min_prob", 1e-3));
+    std::shared_ptr<const PatternDfa> dfa;
+    if (!pattern.empty()) {
+        std::string error;
+        dfa = patterns_->get(pattern, char_list_, &error);
+        if (!dfa)
+            std::cerr << "Mẫu \"" << pattern << "\" không hợp lệ: " << error << std::endl;
+    }
+    const bool use_lattice = dfa || beam_search;
+    std::vector<DecodeResult> results(crops.size(), DecodeResult{"", 0.f});
+
+    std::vector<RecPiece> pieces;
+    std::deque<cv::Mat> rois;
+    SplitCrops(crops, config, pieces, rois);
+
+    // Cache: kết quả chỉ dùng lại được với cùng cách decode.
+    const uint64_t variant =
+        cache_ ? std::hash<std::string>()(dfa ? "p" + pattern
+                                              : beam_search ? "b" + std::to_string(beam_width) + "," +
+                                                                  std::to_string(beam_min_prob) + "," +
+                                                                  std::to_string(lexicon_id)
+                                                            : std::string("g"))
+               : 0;
+    struct Miss {
+        size_t owner;
+        int width;
+        RecFingerprint fingerprint;
+    };
+    std::vector<Miss> misses;
+    // Crop owner cùng nội dung với crop trượt source trong lượt này: lấy kết quả của source sau khi decode.
+    struct Copy {
+        size_t owner;
+        size_t source;
+        int width;
+    };
+    std::vector<Copy> copies;
+    uint64_t hits = 0;
+    if (cache_) {
+        // Input của crop trượt được giữ lại trong inputs cho runPieces (không crop + resize lần hai), tối đa
+        // kMaxKeptInput số float; crop trượt sau đó được chuẩn bị lại trong runPieces như khi không có cache.
+        size_t total = 0;
+        for (const RecPiece &piece : pieces)
+            total += static_cast<size_t>(3) * kInputHeight * piece.width;
+        const size_t capacity = std::min(total, kMaxKeptInput);
+        std::unique_ptr<float[]> inputs(new float[capacity]);
+        thread_local std::vector<float> scratch;
+        size_t used = 0;
+        // Crop trượt theo bucket chiều rộng của cache: chỉ so dấu vân tay với crop cùng bucket.
+        std::unordered_map<int, std::vector<size_t>> misses_by_bucket;
+        std::vector<RecPiece> remaining;
+        remaining.reserve(pieces.size());
+        for (size_t i = 0; i < pieces.size(); i++) {
+            RecPiece piece = pieces[i];
+            const bool chunked = (i > 0 && pieces[i - 1].owner == piece.owner) ||
+                                 (i + 1 < pieces.size() && pieces[i + 1].owner == piece.owner);
+            if (chunked) {
+                remaining.push_back(piece);
+                continue;
+            }
+            const size_t input_size = static_cast<size_t>(3) * kInputHeight * piece.width;
+            const bool keep = used + input_size <= capacity;
+            if (!keep)
+                scratch.resize(input_size);
+            float *input = keep ? inputs.get() + used : scratch.data();
+            fillInput(piece.crop, piece.width, input, piece.width);
+            RecFingerprint fingerprint = FingerprintRecInput(input, kInputHeight, piece.width, piece.width);
+            if (cache_->find(variant, piece.width, fingerprint, results[piece.owner])) {
+                RescaleToWidth(results[piece.owner], piece.width);
+                hits++;
+                continue;
+            }
+            std::vector<size_t> &same_bucket = misses_by_bucket[piece.width / RecCache::kWidthStep];
+            auto same = std::find_if(same_bucket.begin(), same_bucket.end(), [&](size_t m) {
+                return cache_->matches(misses[m].width, misses[m].fingerprint, piece.width, fingerprint);
+            });
+            if (same != same_bucket.end()) {
+                copies.push_back(Copy{piece.owner, misses[*same].owner, piece.width});
+                continue;
+            }
+            same_bucket.push_back(misses.size());
+            misses.push_back(Miss{piece.owner, piece.width, std::move(fingerprint)});
+            if (keep) {
+                piece.input = input;
+                used += input_size;
             }
+            remaining.push_back(piece);
+        }
+        pieces.swap(remaining);
+    }
+
+    // Greedy chỉ cần đường argmax; beam search và decode theo mẫu giữ lattice thưa của mỗi đoạn.
+    std::vector<CtcPath> paths(use_lattice ? 0 : pieces.size());
+    std::vector<CtcLattice> lattices(use_lattice ? pieces.size() : 0);
+    runPieces(pieces, max_batch, [&](size_t i, const float *probs, int steps, int num_classes, int first_step) {
+        if (dfa)
+            dfa->appendLattice(probs, steps, num_classes, first_step, lattices[i]);
+        else if (beam_search)
+            AppendLattice(probs, steps, num_classes, first_step, beam_min_prob, beam_width, lattices[i]);
+        else
+            AppendArgmax(probs, steps, num_classes, first_step, paths[i]);
+    });
+
+    for (size_t begin = 0; begin < pieces.size();) {
+        size_t end = begin + 1;
+        while (end < pieces.size() && pieces[end].owner == pieces[begin].owner)
+            end++;
+        DecodeResult &result = results[pieces[begin].owner];
+        if (dfa)
+            result = end - begin == 1 ? PatternDecode(lattices[begin], char_list_, *dfa)
+                                      : PatternDecode(StitchChunks(pieces, lattices, begin, end), char_list_, *dfa);
+        else if (beam_search)
+            result = end - begin == 1
+                         ? BeamSearchDecode(lattices[begin], char_list_, beam_width, lexicon)
+                         : BeamSearchDecode(StitchChunks(pieces, lattices, begin, end), char_list_, beam_width,
+                                            lexicon);
+        else
+            result = end - begin == 1 ? CollapsePath(paths[begin], char_list_)
+                                      : CollapsePath(StitchChunks(pieces, paths, begin, end), char_list_);
+        result.step_width = pieces[begin].step_width;
+        result.input_width = pieces[end - 1].offset + pieces[end - 1].width;
+        begin = end;
+    }
+
+    if (cache_) {
+        for (const Miss &miss : misses)
+            cache_->insert(variant, miss.width, miss.fingerprint, results[miss.owner]);
+        for (const Copy &copy : copies) {
+            results[copy.owner] = results[copy.source];
+            RescaleToWidth(results[copy.owner], copy.width);
         }
-        if (max_index != 0 && max_index != prev_index) {
-            if (max_index < char_list.size()) {
-                result.text += char_list[max_index];
-                confidence_sum += max_val;
-                count++;
+        cache_->addStats(hits + copies.size(), misses.size());
+    }
+    return results;
+}
+
+std::shared_ptr<const KeywordSet> RecProcess::compileKeywords(const std::vector<std::string> &keywords) const {
+    return std::make_shared<const KeywordSet>(keywords, char_list_);
+}
+
+std::vector<KeywordHit> RecProcess::spotKeywords(const std::vector<RecCrop> &crops, const KeywordSet &keywords,
+                                                 const std::map<std::string, double> &config) {
+    const size_t max_batch = static_cast<size_t>(std::max(1.0, ConfigOr(config, "rec_batch_size", 8)));
+    const float threshold = static_cast<float>(ConfigOr(config, "kws_threshold", 0.6));
+    std::vector<KeywordHit> hits;
+
+    std::vector<RecPiece> pieces;
+    std::deque<cv::Mat> rois;
+    SplitCrops(crops, config, pieces, rois);
+    std::vector<KeywordFrames> frames(pieces.size());
+    runPieces(pieces, max_batch, [&](size_t i, const float *probs, int steps, int num_classes, int first_step) {
+        AppendKeywordFrames(probs, steps, num_classes, first_step, keywords, frames[i]);
+    });
+
+    for (size_t begin = 0; begin < pieces.size();) {
+        size_t end = begin + 1;
+        while (end < pieces.size() && pieces[end].owner == pieces[begin].owner)
+            end++;
+        const size_t owner = pieces[begin].owner;
+        const size_t first_hit = hits.size();
+        if (end - begin == 1)
+            ScoreKeywords(frames[begin], keywords, threshold, owner, hits);
+        else
+            ScoreKeywords(StitchChunks(pieces, frames, begin, end), keywords, threshold, owner, hits);
+
+        // Khoảng bước của từ khóa -> phần tương ứng theo chiều rộng của box crop.
+        const float step_width = pieces[begin].step_width;
+        const float input_width = static_cast<float>(pieces[end - 1].offset + pieces[end - 1].width);
+        const RecCrop &crop = crops[owner];
+        for (size_t h = first_hit; h < hits.size(); h++) {
+            const float t0 = std::min(1.f, hits[h].start_step * step_width / input_width);
+            const float t1 = std::min(1.f, hits[h].end_step * step_width / input_width);
+            if (crop.whole_image) {
+                const float x0 = t0 * crop.source->cols, x1 = t1 * crop.source->cols;
+                const float y1 = static_cast<float>(crop.source->rows);
+                hits[h].box = Quad{{{x0, 0.f}, {x1, 0.f}, {x1, y1}, {x0, y1}}, hits[h].score, 0.f};
+            } else {
+                hits[h].box = SubQuad(crop.box, t0, t1);
+                hits[h].box.score = hits[h].score;
             }
         }
-        prev_index = max_index;
+        begin = end;
     }
-    result.confidence = (count > 0) ? (confidence_sum / count) : 0.f;
-    return result;
+    return hits;
 }
 
-DecodeResult RecProcess::recognize(const cv::Mat &img) {
-    // Giả sử ảnh đầu vào đã được crop chứa vùng chữ
-    // Thiết lập kích thước đầu vào cố định (ví dụ: chiều cao target_h và width được tính theo tỉ lệ)
-    int target_h = 48;
-    int new_width = static_cast<int>(img.cols * (target_h / static_cast<float>(img.rows)));
-    cv::Mat resized;
-    cv::resize(img, resized, cv::Size(new_width, target_h));
-    // Đổi sang float và chuẩn hóa [0,1]
-    resized.convertTo(resized, CV_32FC3, 1.0 / 255);
-    // Nếu cần pad để có kích thước cố định (ví dụ: fixed_width), bạn có thể bổ sung ở đây.
-    // Ở đây ta lấy kích thước hiện có.
-    int fixed_width = new_width;
-    
-    std::vector<int64_t> input_shape = {1, 3, target_h, fixed_width};
-    auto input_tensor = predictor_->GetInput(0);
-    input_tensor->Resize(input_shape);
-    float* input_data = input_tensor->mutable_data<float>();
-    
-    // Tách kênh (OpenCV đọc ảnh theo thứ tự BGR)
-    std::vector<cv::Mat> channels;
-    cv::split(resized, channels);
-    size_t channel_size = target_h * fixed_width;
-    // Giả sử mô hình nhận input theo thứ tự BGR (nếu cần chuyển sang RGB thì thay đổi thứ tự)
-    for (int c = 0; c < 3; ++c) {
-        std::memcpy(input_data + c * channel_size, channels[c].data, channel_size * sizeof(float));
-    }
-    
-    predictor_->Run();
-    auto output_tensor = predictor_->GetOutput(0);
-    auto output_shape = output_tensor->shape(); // [1, seq_len, num_classes]
-    int seq_len = output_shape[1];
-    int num_classes = output_shape[2];
-    const float* output_data = output_tensor->data<float>();
-    
-    return ctcGreedyDecoder(output_data, seq_len, num_classes, char_list_);
+void RecProcess::warmUp(int max_batch) {
+    max_batch = std::max(1, max_batch);
+    std::vector<std::pair<int, int>> shapes;
+    for (int width : bucket_widths_)
+        shapes.emplace_back(max_batch, width);
+    warmUp(shapes);
+}
+
+void RecProcess::warmUp(const std::vector<std::pair<int, int>> &shapes) {
+    for (const auto &shape : shapes) {
+        const int batch = shape.first, width = shape.second;
+        if (batch <= 0 || width <= 0)
+            continue;
+        PaddlePredictor *predictor = predictorForShape(batch, width);
+        auto input_tensor = predictor->GetInput(0);
+        input_tensor->Resize({batch, 3, kInputHeight, width});
+        float *input_data = input_tensor->mutable_data<float>();
+        std::memset(input_data, 0, static_cast<size_t>(batch) * 3 * kInputHeight * width * sizeof(float));
+        predictor->Run();
+    }
 }
 
 } // namespace ocr
@@ -1,32 +1,175 @@
 #pragma once
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
+#include "ctc_decoder.h"
+#include "ctc_pattern.h"
+#include "keyword_spotter.h"
+#include "rec_cache.h"
 #include "opencv2/core.hpp"
 #include "paddle_api.h"
+#include "quad.h"
 
 namespace ocr {
 
-struct DecodeResult {
-    std::string text;
-    float confidence;
+struct RecPiece;
+
+// Một vùng chữ cần nhận dạng: box trên ảnh source, hoặc cả ảnh source nếu đã được crop sẵn.
+struct RecCrop {
+    const cv::Mat *source = nullptr;
+    Quad box{};
+    bool whole_image = false;
+
+    RecCrop() = default;
+    explicit RecCrop(const cv::Mat &image) : source(&image), whole_image(true) {}
+    RecCrop(const cv::Mat &src, const Quad &quad) : source(&src), box(quad) {}
 };
 
 class RecProcess {
 public:
-    // Khởi tạo với đường dẫn mô hình recognition và từ điển ký tự.
-    RecProcess(const std::string &model_path, const std::string &char_dict_path);
+    // Khởi tạo với đường dẫn mô hình recognition, từ điển ký tự và số luồng Paddle Lite của predictor.
+    RecProcess(const std::string &model_path, const std::string &char_dict_path, int cpu_threads = 1);
+
+    // Bản sao độc lập dùng chung trọng số mô hình (predictor_->Clone()) và cấu hình bucket.
+    // Mỗi RecProcess không reentrant; để nhận dạng song song, mỗi luồng dùng một bản sao (xem RecPool).
+    std::unique_ptr<RecProcess> clone() const;
+
+    // Chiều rộng input (tại chiều cao 48) của crop, 0 nếu crop rỗng.
+    static int InputWidth(const RecCrop &crop);
     
     // Hàm recognize: nhận ảnh (crop vùng chữ) và trả về kết quả decode.
+    // Input được pad phải lên bucket chiều rộng chuẩn như recognizeBatch (lô một phần tử).
     DecodeResult recognize(const cv::Mat &img);
+    // Như trên nhưng crop box trực tiếp từ ảnh src vào tensor input (không tạo ảnh crop trung gian).
+    DecodeResult recognize(const cv::Mat &src, const Quad &box);
+
+    // Nhận dạng theo lô: các crop được sắp theo chiều rộng input (tỷ lệ khung hình), gom vào bucket
+    // chiều rộng nhỏ nhất chứa được chúng (setWidthBuckets), pad phải bằng 0 và chạy
+    // {N, 3, 48, W_bucket} với N <= config["rec_batch_size"] (mặc định 8); N được làm tròn lên lũy thừa 2
+    // (không vượt rec_batch_size) bằng phần tử rỗng. Crop rộng hơn bucket lớn nhất được pad lên bội số 160.
+    // Mỗi shape (N, W) có predictor riêng nên bộ nhớ trung gian được giữ lại giữa các lần gọi.
+    // Dòng có chiều rộng input lớn hơn config["rec_max_chunk_width"] (mặc định 960, 0 = tắt) được chia
+    // thành các đoạn rộng đúng rec_max_chunk_width, chồng lấn ít nhất config["rec_chunk_overlap"] cột
+    // (mặc định 96), chạy theo lô như các crop khác; đường argmax của các đoạn được ghép tại một bước blank
+    // chung của hai đoạn gần điểm giữa vùng chồng lấn rồi mới gộp CTC, nên kết quả vẫn là một DecodeResult
+    // cho mỗi dòng.
+    // Decoder: config["rec_decoder"] = 0 (mặc định) là greedy; 1 là prefix beam search với
+    // config["rec_beam_width"] tiền tố (mặc định 5), mỗi bước chỉ xét tối đa rec_beam_width lớp có xác suất
+    // >= config["rec_beam_min_prob"] (mặc định 1e-3). config["rec_lexicon"] = id của loadLexicon giới hạn
+    // kết quả trong từ vựng đó (tự chuyển sang beam search).
+    // pattern khác rỗng: decode ràng buộc theo mẫu định dạng (PatternDfa / PatternDecode, thay cho các
+    // decoder trên), mỗi crop nhận chuỗi khớp mẫu tốt nhất hoặc text "" nếu không có. DFA của mẫu được
+    // biên dịch ở lần dùng đầu rồi cache (dùng chung với các bản clone); mẫu sai cú pháp được báo ra
+    // stderr và decode như không có mẫu.
+    // Với cache (enableCache / setCache), crop không bị chia đoạn được lấy dấu vân tay (hash và ảnh thu nhỏ,
+    // xem RecCache) từ input đã chuẩn hóa trước khi chạy mô hình: crop trúng cache, hoặc cùng nội dung với
+    // một crop trước đó trong cùng lượt, lấy lại kết quả đã có (step_width / input_width đổi theo chiều rộng
+    // input của crop) và không được đưa vào predictor. Input đã chuẩn hóa của crop trượt được dùng lại cho
+    // predictor (không crop + resize hai lần); crop trượt chỉ được so với crop trượt trước đó cùng bucket.
+    // Kết quả trả về theo đúng thứ tự đầu vào; crop rỗng cho text "".
+    std::vector<DecodeResult> recognizeBatch(const std::vector<RecCrop> &crops,
+                                             const std::map<std::string, double> &config,
+                                             const std::string &pattern = "");
+
+    // Tập từ khóa theo từ điển ký tự của mô hình, dùng cho spotKeywords (biên dịch một lần, dùng lại).
+    std::shared_ptr<const KeywordSet> compileKeywords(const std::vector<std::string> &keywords) const;
+
+    // Dò từ khóa thay cho nhận dạng đầy đủ: chạy mô hình như recognizeBatch (cùng bucket, batch, chia đoạn
+    // dòng dài) nhưng mỗi bước output chỉ giữ argmax và xác suất của các lớp có trong từ khóa, không decode
+    // thành chuỗi. Dòng không chung ký tự nào với từ khóa nào trên đường greedy bị loại ngay; từ khóa được
+    // chấm bằng căn chỉnh CTC (ScoreKeywords) và chỉ trả về các từ khóa có điểm >= config["kws_threshold"]
+    // (mặc định 0.6), mỗi cặp (crop, từ khóa) nhiều nhất một kết quả, theo thứ tự crop. box của kết quả là
+    // phần của box crop chứa từ khóa (với crop cả ảnh: hình chữ nhật trên ảnh đó).
+    std::vector<KeywordHit> spotKeywords(const std::vector<RecCrop> &crops, const KeywordSet &keywords,
+                                         const std::map<std::string, double> &config);
+
+    // Text (UTF-8) có khớp toàn bộ mẫu định dạng pattern không (cú pháp của PatternDfa, DFA được cache như
+    // ở recognizeBatch); false nếu text có ký tự ngoài từ điển hoặc mẫu sai cú pháp. An toàn khi gọi từ
+    // nhiều luồng.
+    bool matchesPattern(const std::string &text, const std::string &pattern) const;
+    // Như trên với DFA đã biên dịch (compilePattern), không tra cache mẫu mỗi lần gọi.
+    bool matchesPattern(const std::string &text, const PatternDfa &dfa) const;
+    // DFA của mẫu theo từ điển ký tự của mô hình (cache như ở recognizeBatch); nullptr kèm thông báo trong
+    // error nếu mẫu sai cú pháp.
+    std::shared_ptr<const PatternDfa> compilePattern(const std::string &pattern, std::string *error = nullptr) const;
+
+    // Biên dịch file từ vựng words_path (mỗi dòng một từ, UTF-8) thành file trie trie_path theo từ điển ký tự
+    // của mô hình (xem LexiconTrie). Trả về số từ đã đưa vào trie, -1 nếu lỗi.
+    int compileLexicon(const std::string &words_path, const std::string &trie_path) const;
+    // Map file trie và đăng ký nó cho recognizeBatch; trả về id (>= 1) dùng cho config["rec_lexicon"],
+    // 0 nếu không mở được file.
+    int loadLexicon(const std::string &trie_path);
+    // Đăng ký một trie đã mở (dùng chung giữa các recognizer), trả về id như loadLexicon.
+    int addLexicon(std::shared_ptr<const LexiconTrie> lexicon);
+
+    // Bật cache kết quả recognition (RecCache) tối đa capacity mục, crop có hash cách nhau không quá
+    // max_distance bit (trên 256) là ứng viên cùng nội dung, được xác nhận bằng ảnh thu nhỏ; capacity 0 tắt
+    // cache. Bản clone tạo sau dùng chung cache.
+    void enableCache(size_t capacity, int max_distance = 8);
+    // Dùng một cache có sẵn (dùng chung giữa các recognizer), nullptr để tắt.
+    void setCache(std::shared_ptr<RecCache> cache);
+    // Bộ đếm trúng / trượt và số mục của cache (0 nếu không bật).
+    RecCacheStats cacheStats() const;
+
+    // Thiết lập các bucket chiều rộng input (pixel, tại chiều cao 48) cho recognizeBatch.
+    void setWidthBuckets(const std::vector<int> &widths);
+
+    // Chạy trước mỗi bucket chiều rộng với batch max_batch (shape của các lô đầy) một lần để predictor của
+    // chúng đã lập kế hoạch và cấp phát bộ nhớ trước khi nhận dạng ảnh thật. Chỉ các shape đó được tạo trước:
+    // predictor của lô lẻ (batch chuẩn nhỏ hơn max_batch, tức phần dư của mỗi bucket) và của dòng rộng hơn
+    // bucket lớn nhất được tạo lười ở lần đầu gặp, nên lượt nhận dạng đầu tiên chứa chúng vẫn chậm hơn.
+    // Predictor của các shape trong bucket được giữ suốt đời recognizer (đến setWidthBuckets).
+    void warmUp(int max_batch);
+    // Như trên nhưng chỉ với các shape (batch, chiều rộng input) cho trước. Shape rộng hơn bucket lớn nhất
+    // chỉ được giữ trong kMaxWidePredictors shape rộng dùng gần nhất.
+    void warmUp(const std::vector<std::pair<int, int>> &shapes);
 
 private:
+    RecProcess() = default;
+
+    // Chiều cao input của mô hình recognition.
+    static constexpr int kInputHeight = 48;
+    // Bước làm tròn chiều rộng cho dòng rộng hơn bucket lớn nhất.
+    static constexpr int kWideWidthStep = 160;
+    // Số predictor của shape rộng hơn bucket lớn nhất giữ lại tối đa; shape rộng dùng lâu nhất bị bỏ khi vượt.
+    static constexpr size_t kMaxWidePredictors = 8;
+    // Crop + resize một RecCrop vào tensor (3 x kInputHeight x row_stride), chiều rộng width.
+    void fillInput(const RecCrop &crop, int width, float *dst, int row_stride);
+    // Bucket chiều rộng cho crop rộng width (bội số kWideWidthStep nếu vượt bucket lớn nhất).
+    int bucketWidth(int width) const;
+    // Chạy mô hình cho các đoạn theo lô (sắp theo chiều rộng, gom theo bucket, pad lên batch chuẩn) và gọi
+    // consume(chỉ số đoạn, output của đoạn, số bước thời gian thật, số lớp, chỉ số bước đầu trên cả dòng)
+    // khi output của lô còn trong tensor; điền step_width của từng đoạn.
+    void runPieces(std::vector<RecPiece> &pieces, size_t max_batch,
+                   const std::function<void(size_t, const float *, int, int, int)> &consume);
+    // Predictor dành riêng cho một shape (batch, width) (clone từ predictor_, dùng chung trọng số); shape rộng
+    // được đưa lên đầu LRU. Con trỏ hợp lệ đến lần gọi predictorForShape kế tiếp.
+    paddle::lite_api::PaddlePredictor *predictorForShape(int batch, int width);
     // Hàm load từ điển ký tự từ file.
     std::vector<std::string> loadCharDict(const std::string &dict_path);
-    // Hàm giải mã CTC theo phương pháp greedy.
-    DecodeResult ctcGreedyDecoder(const float* probs, int seq_len, int num_classes, const std::vector<std::string>& char_list);
 
     std::vector<std::string> char_list_;
     std::shared_ptr<paddle::lite_api::PaddlePredictor> predictor_;
+    // Các bucket chiều rộng (tăng dần) của recognizeBatch.
+    std::vector<int> bucket_widths_ = {80, 160, 240, 320, 480, 640, 960};
+    // Mỗi shape (batch, width) giữ một predictor riêng để không phải lập lại kế hoạch bộ nhớ khi đổi shape.
+    // Shape trong bucket: tối đa số bucket x số batch chuẩn (lũy thừa 2 <= rec_batch_size), không bị bỏ.
+    std::map<std::pair<int, int>, std::shared_ptr<paddle::lite_api::PaddlePredictor>> batch_predictors_;
+    // Shape rộng hơn bucket lớn nhất (LRU, đầu danh sách là shape vừa dùng, tối đa kMaxWidePredictors mục).
+    using ShapePredictor = std::pair<std::pair<int, int>, std::shared_ptr<paddle::lite_api::PaddlePredictor>>;
+    std::list<ShapePredictor> wide_predictors_;
+    std::map<std::pair<int, int>, std::list<ShapePredictor>::iterator> wide_predictor_index_;
+    // Các trie từ vựng đã đăng ký, id = vị trí + 1 (chỉ đọc, dùng chung với các bản clone).
+    std::vector<std::shared_ptr<const LexiconTrie>> lexicons_;
+    // DFA đã biên dịch theo mẫu, dùng chung với các bản clone.
+    std::shared_ptr<PatternDfaCache> patterns_ = std::make_shared<PatternDfaCache>();
+    // Tách text thành lớp của từ điển cho matchesPattern (dựng một lần, dùng chung với các bản clone).
+    std::shared_ptr<const CharListIndex> char_index_;
+    // Cache kết quả recognition, nullptr nếu không bật (dùng chung với các bản clone).
+    std::shared_ptr<RecCache> cache_;
 };
 
 } // namespace ocr
@@ -0,0 +1,562 @@
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define OCR_SIMD_X86 1
+#endif
+
+namespace ocr {
+
+namespace {
+
+// Bộ đệm tạm dùng lại giữa các lần gọi (mỗi luồng một bộ) để không cấp phát lại mỗi ảnh.
+struct ResizeScratch {
+    std::vector<int> xofs0;   // offset phần tử (x0 * 3) của cột nguồn bên trái
+    std::vector<int> xofs1;   // offset phần tử (x1 * 3) của cột nguồn bên phải
+    std::vector<float> xw;    // trọng số nội suy theo x
+    std::vector<float> row;   // một hàng nguồn đã nội suy theo y (BGR xen kẽ, float)
+};
+
+ResizeScratch &GetScratch() {
+    thread_local ResizeScratch scratch;
+    return scratch;
+}
+
+// Hai hàng nhị phân (hàng hiện tại và hàng trước) cho bước giãn nở 2x2.
+struct BitmapScratch {
+    std::vector<uint8_t> rows[2];
+};
+
+BitmapScratch &GetBitmapScratch() {
+    thread_local BitmapScratch scratch;
+    return scratch;
+}
+
+// Ánh xạ tọa độ giống cv::resize INTER_LINEAR: (dx + 0.5) * ratio - 0.5, kẹp về biên.
+inline void MapCoord(int d, float ratio, int src_len, int &s0, int &s1, float &w) {
+    float f = (d + 0.5f) * ratio - 0.5f;
+    int s = static_cast<int>(std::floor(f));
+    f -= s;
+    if (s < 0) {
+        s = 0;
+        f = 0.f;
+    }
+    if (s >= src_len - 1) {
+        s = src_len - 1;
+        f = 0.f;
+    }
+    s0 = s;
+    s1 = std::min(s + 1, src_len - 1);
+    w = f;
+}
+
+// ---------------- Scalar ----------------
+
+void VBlendScalar(const uint8_t *a, const uint8_t *b, float wy, float *out, int n) {
+    for (int i = 0; i < n; i++) {
+        float fa = a[i];
+        out[i] = fa + (static_cast<float>(b[i]) - fa) * wy;
+    }
+}
+
+// Nội suy theo x trên hàng đã blend, chuẩn hóa và ghi ra 3 mặt phẳng kênh.
+void HBlendScalar(const float *row, const int *xofs0, const int *xofs1, const float *xw,
+                  int begin, int new_w, const float alpha[3], const float beta[3],
+                  float *dst0, float *dst1, float *dst2) {
+    float *dst[3] = {dst0, dst1, dst2};
+    for (int x = begin; x < new_w; x++) {
+        const float *p0 = row + xofs0[x];
+        const float *p1 = row + xofs1[x];
+        float w = xw[x];
+        for (int c = 0; c < 3; c++) {
+            float v = p0[c] + (p1[c] - p0[c]) * w;
+            dst[c][x] = v * alpha[c] + beta[c];
+        }
+    }
+}
+
+// out[x] = (int)(p[x] * 255) > ithresh ? 255 : 0 (phép cast float -> uchar của code cũ là cắt phần thập phân).
+void BinarizeScalar(const float *p, int begin, int n, int ithresh, uint8_t *out) {
+    for (int x = begin; x < n; x++)
+        out[x] = static_cast<int>(p[x] * 255.f) > ithresh ? 255 : 0;
+}
+
+// out[x] = cur[x] | cur[x - 1] | prev[x] | prev[x - 1] (prev có thể null ở hàng đầu, cột -1 bị bỏ qua).
+void DilateRowScalar(const uint8_t *cur, const uint8_t *prev, int begin, int n, uint8_t *out) {
+    for (int x = begin; x < n; x++) {
+        uint8_t v = cur[x];
+        if (x > 0)
+            v |= cur[x - 1];
+        if (prev) {
+            v |= prev[x];
+            if (x > 0)
+                v |= prev[x - 1];
+        }
+        out[x] = v;
+    }
+}
+
+// Argmax của một hàng: phần tử lớn nhất đầu tiên (so sánh >, như vòng lặp decode cũ), từ vị trí begin
+// với giá trị / vị trí tốt nhất hiện có.
+void ArgmaxRowScalar(const float *row, int begin, int n, int &best_index, float &best_value) {
+    for (int j = begin; j < n; j++) {
+        if (row[j] > best_value) {
+            best_value = row[j];
+            best_index = j;
+        }
+    }
+}
+
+// Ghi vị trí các phần tử row[j] >= thresh, j trong [begin, n), vào index từ vị trí count; trả về count mới.
+int SelectAboveScalar(const float *row, int begin, int n, float thresh, int *index, int count) {
+    for (int j = begin; j < n; j++) {
+        if (row[j] >= thresh)
+            index[count++] = j;
+    }
+    return count;
+}
+
+#ifdef OCR_SIMD_X86
+
+// ---------------- SSE2 ----------------
+
+// Mỗi lane giữ max và vị trí đầu tiên đạt max của các phần tử j = lane (mod 4); gộp các lane bằng
+// cách lấy max rồi vị trí nhỏ nhất trong các lane bằng max, nên kết quả trùng với nhánh scalar.
+void ArgmaxRowSSE2(const float *row, int n, int &best_index, float &best_value) {
+    best_index = 0;
+    best_value = row[0];
+    if (n < 8) {
+        ArgmaxRowScalar(row, 1, n, best_index, best_value);
+        return;
+    }
+    __m128 vmax = _mm_loadu_ps(row);
+    __m128i vidx = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i cur = vidx;
+    const __m128i step = _mm_set1_epi32(4);
+    int j = 4;
+    for (; j + 4 <= n; j += 4) {
+        cur = _mm_add_epi32(cur, step);
+        __m128 v = _mm_loadu_ps(row + j);
+        __m128 gt = _mm_cmpgt_ps(v, vmax);
+        vmax = _mm_or_ps(_mm_and_ps(gt, v), _mm_andnot_ps(gt, vmax));
+        __m128i gti = _mm_castps_si128(gt);
+        vidx = _mm_or_si128(_mm_and_si128(gti, cur), _mm_andnot_si128(gti, vidx));
+    }
+    alignas(16) float values[4];
+    alignas(16) int indices[4];
+    _mm_store_ps(values, vmax);
+    _mm_store_si128(reinterpret_cast<__m128i *>(indices), vidx);
+    best_value = values[0];
+    best_index = indices[0];
+    for (int k = 1; k < 4; k++) {
+        if (values[k] > best_value || (values[k] == best_value && indices[k] < best_index)) {
+            best_value = values[k];
+            best_index = indices[k];
+        }
+    }
+    ArgmaxRowScalar(row, j, n, best_index, best_value);
+}
+
+// Hầu hết các lớp dưới ngưỡng: so sánh 4 phần tử một lần, chỉ duyệt từng bit khi mask khác 0.
+int SelectAboveSSE2(const float *row, int n, float thresh, int *index) {
+    const __m128 t = _mm_set1_ps(thresh);
+    int count = 0, j = 0;
+    for (; j + 4 <= n; j += 4) {
+        int mask = _mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + j), t));
+        while (mask) {
+            index[count++] = j + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    return SelectAboveScalar(row, j, n, thresh, index, count);
+}
+
+void BinarizeSSE2(const float *p, int n, int ithresh, uint8_t *out) {
+    const __m128 k255 = _mm_set1_ps(255.f);
+    const __m128i t = _mm_set1_epi32(ithresh);
+    int x = 0;
+    for (; x + 16 <= n; x += 16) {
+        __m128i m0 = _mm_cmpgt_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(p + x), k255)), t);
+        __m128i m1 = _mm_cmpgt_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(p + x + 4), k255)), t);
+        __m128i m2 = _mm_cmpgt_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(p + x + 8), k255)), t);
+        __m128i m3 = _mm_cmpgt_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(p + x + 12), k255)), t);
+        // Mặt nạ -1/0 bão hòa thành 0xFF/0x00.
+        __m128i b = _mm_packs_epi16(_mm_packs_epi32(m0, m1), _mm_packs_epi32(m2, m3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), b);
+    }
+    BinarizeScalar(p, x, n, ithresh, out);
+}
+
+void DilateRowSSE2(const uint8_t *cur, const uint8_t *prev, int n, uint8_t *out) {
+    // Cột 0 không có cột bên trái, xử lý riêng.
+    DilateRowScalar(cur, prev, 0, std::min(n, 1), out);
+    int x = 1;
+    for (; x + 16 <= n; x += 16) {
+        __m128i v = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(cur + x)),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i *>(cur + x - 1)));
+        if (prev) {
+            v = _mm_or_si128(v, _mm_loadu_si128(reinterpret_cast<const __m128i *>(prev + x)));
+            v = _mm_or_si128(v, _mm_loadu_si128(reinterpret_cast<const __m128i *>(prev + x - 1)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), v);
+    }
+    DilateRowScalar(cur, prev, x, n, out);
+}
+
+void VBlendSSE2(const uint8_t *a, const uint8_t *b, float wy, float *out, int n) {
+    const __m128 w = _mm_set1_ps(wy);
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        __m128i a16[2] = {_mm_unpacklo_epi8(va, zero), _mm_unpackhi_epi8(va, zero)};
+        __m128i b16[2] = {_mm_unpacklo_epi8(vb, zero), _mm_unpackhi_epi8(vb, zero)};
+        for (int h = 0; h < 2; h++) {
+            __m128 fa_lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(a16[h], zero));
+            __m128 fa_hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(a16[h], zero));
+            __m128 fb_lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(b16[h], zero));
+            __m128 fb_hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(b16[h], zero));
+            _mm_storeu_ps(out + i + h * 8,
+                          _mm_add_ps(fa_lo, _mm_mul_ps(_mm_sub_ps(fb_lo, fa_lo), w)));
+            _mm_storeu_ps(out + i + h * 8 + 4,
+                          _mm_add_ps(fa_hi, _mm_mul_ps(_mm_sub_ps(fb_hi, fa_hi), w)));
+        }
+    }
+    VBlendScalar(a + i, b + i, wy, out + i, n - i);
+}
+
+void HBlendSSE2(const float *row, const int *xofs0, const int *xofs1, const float *xw,
+                int new_w, const float alpha[3], const float beta[3],
+                float *dst0, float *dst1, float *dst2) {
+    float *dst[3] = {dst0, dst1, dst2};
+    int x = 0;
+    for (; x + 4 <= new_w; x += 4) {
+        const int *o0 = xofs0 + x;
+        const int *o1 = xofs1 + x;
+        __m128 w = _mm_loadu_ps(xw + x);
+        for (int c = 0; c < 3; c++) {
+            __m128 v0 = _mm_set_ps(row[o0[3] + c], row[o0[2] + c], row[o0[1] + c], row[o0[0] + c]);
+            __m128 v1 = _mm_set_ps(row[o1[3] + c], row[o1[2] + c], row[o1[1] + c], row[o1[0] + c]);
+            __m128 v = _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), w));
+            v = _mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(alpha[c])), _mm_set1_ps(beta[c]));
+            _mm_storeu_ps(dst[c] + x, v);
+        }
+    }
+    HBlendScalar(row, xofs0, xofs1, xw, x, new_w, alpha, beta, dst0, dst1, dst2);
+}
+
+// ---------------- AVX2 ----------------
+
+__attribute__((target("avx2")))
+void VBlendAVX2(const uint8_t *a, const uint8_t *b, float wy, float *out, int n) {
+    const __m256 w = _mm256_set1_ps(wy);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 fa = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(a + i))));
+        __m256 fb = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(b + i))));
+        _mm256_storeu_ps(out + i, _mm256_add_ps(fa, _mm256_mul_ps(_mm256_sub_ps(fb, fa), w)));
+    }
+    VBlendScalar(a + i, b + i, wy, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void HBlendAVX2(const float *row, const int *xofs0, const int *xofs1, const float *xw,
+                int new_w, const float alpha[3], const float beta[3],
+                float *dst0, float *dst1, float *dst2) {
+    float *dst[3] = {dst0, dst1, dst2};
+    int x = 0;
+    for (; x + 8 <= new_w; x += 8) {
+        __m256i i0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(xofs0 + x));
+        __m256i i1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(xofs1 + x));
+        __m256 w = _mm256_loadu_ps(xw + x);
+        for (int c = 0; c < 3; c++) {
+            __m256 v0 = _mm256_i32gather_ps(row + c, i0, 4);
+            __m256 v1 = _mm256_i32gather_ps(row + c, i1, 4);
+            __m256 v = _mm256_add_ps(v0, _mm256_mul_ps(_mm256_sub_ps(v1, v0), w));
+            v = _mm256_add_ps(_mm256_mul_ps(v, _mm256_set1_ps(alpha[c])), _mm256_set1_ps(beta[c]));
+            _mm256_storeu_ps(dst[c] + x, v);
+        }
+    }
+    HBlendScalar(row, xofs0, xofs1, xw, x, new_w, alpha, beta, dst0, dst1, dst2);
+}
+
+__attribute__((target("avx2")))
+void BinarizeAVX2(const float *p, int n, int ithresh, uint8_t *out) {
+    const __m256 k255 = _mm256_set1_ps(255.f);
+    const __m256i t = _mm256_set1_epi32(ithresh);
+    // packs_* làm việc theo từng nửa 128 bit, hoán vị lại để giữ đúng thứ tự.
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int x = 0;
+    for (; x + 32 <= n; x += 32) {
+        __m256i m0 = _mm256_cmpgt_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(p + x), k255)), t);
+        __m256i m1 = _mm256_cmpgt_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(p + x + 8), k255)), t);
+        __m256i m2 = _mm256_cmpgt_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(p + x + 16), k255)), t);
+        __m256i m3 = _mm256_cmpgt_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(p + x + 24), k255)), t);
+        __m256i b = _mm256_packs_epi16(_mm256_packs_epi32(m0, m1), _mm256_packs_epi32(m2, m3));
+        b = _mm256_permutevar8x32_epi32(b, order);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), b);
+    }
+    BinarizeScalar(p, x, n, ithresh, out);
+}
+
+__attribute__((target("avx2")))
+void DilateRowAVX2(const uint8_t *cur, const uint8_t *prev, int n, uint8_t *out) {
+    DilateRowScalar(cur, prev, 0, std::min(n, 1), out);
+    int x = 1;
+    for (; x + 32 <= n; x += 32) {
+        __m256i v = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(cur + x)),
+                                    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cur + x - 1)));
+        if (prev) {
+            v = _mm256_or_si256(v, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(prev + x)));
+            v = _mm256_or_si256(v, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(prev + x - 1)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), v);
+    }
+    DilateRowScalar(cur, prev, x, n, out);
+}
+
+__attribute__((target("avx2")))
+void ArgmaxRowAVX2(const float *row, int n, int &best_index, float &best_value) {
+    best_index = 0;
+    best_value = row[0];
+    if (n < 16) {
+        ArgmaxRowScalar(row, 1, n, best_index, best_value);
+        return;
+    }
+    __m256 vmax = _mm256_loadu_ps(row);
+    __m256i vidx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i cur = vidx;
+    const __m256i step = _mm256_set1_epi32(8);
+    int j = 8;
+    for (; j + 8 <= n; j += 8) {
+        cur = _mm256_add_epi32(cur, step);
+        __m256 v = _mm256_loadu_ps(row + j);
+        __m256 gt = _mm256_cmp_ps(v, vmax, _CMP_GT_OQ);
+        vmax = _mm256_blendv_ps(vmax, v, gt);
+        vidx = _mm256_blendv_epi8(vidx, cur, _mm256_castps_si256(gt));
+    }
+    alignas(32) float values[8];
+    alignas(32) int indices[8];
+    _mm256_store_ps(values, vmax);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(indices), vidx);
+    best_value = values[0];
+    best_index = indices[0];
+    for (int k = 1; k < 8; k++) {
+        if (values[k] > best_value || (values[k] == best_value && indices[k] < best_index)) {
+            best_value = values[k];
+            best_index = indices[k];
+        }
+    }
+    ArgmaxRowScalar(row, j, n, best_index, best_value);
+}
+
+__attribute__((target("avx2")))
+int SelectAboveAVX2(const float *row, int n, float thresh, int *index) {
+    const __m256 t = _mm256_set1_ps(thresh);
+    int count = 0, j = 0;
+    for (; j + 16 <= n; j += 16) {
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(row + j), t, _CMP_GE_OQ)) |
+                   (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(row + j + 8), t, _CMP_GE_OQ)) << 8);
+        while (mask) {
+            index[count++] = j + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    return SelectAboveScalar(row, j, n, thresh, index, count);
+}
+
+#endif  // OCR_SIMD_X86
+
+enum class Isa { kScalar, kSSE2, kAVX2 };
+
+Isa DetectIsa() {
+#ifdef OCR_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Isa::kAVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return Isa::kSSE2;
+#endif
+    return Isa::kScalar;
+}
+
+Isa ActiveIsa() {
+    static const Isa isa = DetectIsa();
+    return isa;
+}
+
+void VBlend(Isa isa, const uint8_t *a, const uint8_t *b, float wy, float *out, int n) {
+#ifdef OCR_SIMD_X86
+    if (isa == Isa::kAVX2)
+        return VBlendAVX2(a, b, wy, out, n);
+    if (isa == Isa::kSSE2)
+        return VBlendSSE2(a, b, wy, out, n);
+#endif
+    VBlendScalar(a, b, wy, out, n);
+}
+
+void HBlend(Isa isa, const float *row, const int *xofs0, const int *xofs1, const float *xw,
+            int new_w, const float alpha[3], const float beta[3],
+            float *dst0, float *dst1, float *dst2) {
+#ifdef OCR_SIMD_X86
+    if (isa == Isa::kAVX2)
+        return HBlendAVX2(row, xofs0, xofs1, xw, new_w, alpha, beta, dst0, dst1, dst2);
+    if (isa == Isa::kSSE2)
+        return HBlendSSE2(row, xofs0, xofs1, xw, new_w, alpha, beta, dst0, dst1, dst2);
+#endif
+    HBlendScalar(row, xofs0, xofs1, xw, 0, new_w, alpha, beta, dst0, dst1, dst2);
+}
+
+void Binarize(Isa isa, const float *p, int n, int ithresh, uint8_t *out) {
+#ifdef OCR_SIMD_X86
+    if (isa == Isa::kAVX2)
+        return BinarizeAVX2(p, n, ithresh, out);
+    if (isa == Isa::kSSE2)
+        return BinarizeSSE2(p, n, ithresh, out);
+#endif
+    BinarizeScalar(p, 0, n, ithresh, out);
+}
+
+void DilateRow(Isa isa, const uint8_t *cur, const uint8_t *prev, int n, uint8_t *out) {
+#ifdef OCR_SIMD_X86
+    if (isa == Isa::kAVX2)
+        return DilateRowAVX2(cur, prev, n, out);
+    if (isa == Isa::kSSE2)
+        return DilateRowSSE2(cur, prev, n, out);
+#endif
+    DilateRowScalar(cur, prev, 0, n, out);
+}
+
+void ArgmaxRow(Isa isa, const float *row, int n, int &best_index, float &best_value) {
+#ifdef OCR_SIMD_X86
+    if (isa == Isa::kAVX2)
+        return ArgmaxRowAVX2(row, n, best_index, best_value);
+    if (isa == Isa::kSSE2)
+        return ArgmaxRowSSE2(row, n, best_index, best_value);
+#endif
+    best_index = 0;
+    best_value = row[0];
+    ArgmaxRowScalar(row, 1, n, best_index, best_value);
+}
+
+int SelectAbove(Isa isa, const float *row, int n, float thresh, int *index) {
+#ifdef OCR_SIMD_X86
+    if (isa == Isa::kAVX2)
+        return SelectAboveAVX2(row, n, thresh, index);
+    if (isa == Isa::kSSE2)
+        return SelectAboveSSE2(row, n, thresh, index);
+#endif
+    return SelectAboveScalar(row, 0, n, thresh, index, 0);
+}
+
+} // namespace
+
+const char *SimdKernelIsa() {
+    switch (ActiveIsa()) {
+    case Isa::kAVX2:
+        return "avx2";
+    case Isa::kSSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+void LetterboxNormalizeNCHW(const cv::Mat &src, int new_w, int new_h,
+                            int dst_w, int dst_h, int pad_left, int pad_top,
+                            const float mean[3], const float scale[3], float *dst) {
+    const Isa isa = ActiveIsa();
+    const int src_w = src.cols;
+    const int src_h = src.rows;
+    const size_t plane = static_cast<size_t>(dst_w) * dst_h;
+
+    // (v / 255 - mean) * scale == v * alpha + beta
+    float alpha[3], beta[3];
+    for (int c = 0; c < 3; c++) {
+        alpha[c] = scale[c] / 255.f;
+        beta[c] = -mean[c] * scale[c];
+    }
+
+    // Điền padding: toàn bộ hàng trên/dưới và hai dải trái/phải của vùng ảnh.
+    for (int c = 0; c < 3; c++) {
+        float *p = dst + c * plane;
+        std::fill(p, p + static_cast<size_t>(pad_top) * dst_w, beta[c]);
+        std::fill(p + static_cast<size_t>(pad_top + new_h) * dst_w, p + plane, beta[c]);
+        for (int y = pad_top; y < pad_top + new_h; y++) {
+            float *line = p + static_cast<size_t>(y) * dst_w;
+            std::fill(line, line + pad_left, beta[c]);
+            std::fill(line + pad_left + new_w, line + dst_w, beta[c]);
+        }
+    }
+
+    ResizeScratch &s = GetScratch();
+    s.xofs0.resize(new_w);
+    s.xofs1.resize(new_w);
+    s.xw.resize(new_w);
+    s.row.resize(static_cast<size_t>(src_w) * 3);
+
+    const float ratio_x = static_cast<float>(src_w) / new_w;
+    const float ratio_y = static_cast<float>(src_h) / new_h;
+    for (int x = 0; x < new_w; x++) {
+        int x0, x1;
+        MapCoord(x, ratio_x, src_w, x0, x1, s.xw[x]);
+        s.xofs0[x] = x0 * 3;
+        s.xofs1[x] = x1 * 3;
+    }
+
+    for (int y = 0; y < new_h; y++) {
+        int y0, y1;
+        float wy;
+        MapCoord(y, ratio_y, src_h, y0, y1, wy);
+        VBlend(isa, src.ptr<uint8_t>(y0), src.ptr<uint8_t>(y1), wy, s.row.data(), src_w * 3);
+
+        size_t offset = static_cast<size_t>(pad_top + y) * dst_w + pad_left;
+        HBlend(isa, s.row.data(), s.xofs0.data(), s.xofs1.data(), s.xw.data(), new_w, alpha, beta,
+               dst + offset, dst + plane + offset, dst + 2 * plane + offset);
+    }
+}
+
+void ThresholdDilateBitmap(const float *prob, int h, int w, double thresh, bool dilate, cv::Mat &bitmap) {
+    const Isa isa = ActiveIsa();
+    bitmap.create(h, w, CV_8UC1);
+    // cv::threshold trên ảnh 8 bit dùng ngưỡng nguyên floor(thresh * 255).
+    const double t = std::floor(thresh * 255);
+    const int ithresh = t < 0 ? -1 : (t > 255 ? 255 : static_cast<int>(t));
+
+    if (!dilate) {
+        for (int y = 0; y < h; y++)
+            Binarize(isa, prob + static_cast<size_t>(y) * w, w, ithresh, bitmap.ptr<uint8_t>(y));
+        return;
+    }
+
+    BitmapScratch &s = GetBitmapScratch();
+    s.rows[0].resize(w);
+    s.rows[1].resize(w);
+    for (int y = 0; y < h; y++) {
+        uint8_t *cur = s.rows[y & 1].data();
+        const uint8_t *prev = y > 0 ? s.rows[(y - 1) & 1].data() : nullptr;
+        Binarize(isa, prob + static_cast<size_t>(y) * w, w, ithresh, cur);
+        DilateRow(isa, cur, prev, w, bitmap.ptr<uint8_t>(y));
+    }
+}
+
+void ArgmaxRows(const float *data, int rows, int cols, int *index, float *value) {
+    if (cols <= 0)
+        return;
+    const Isa isa = ActiveIsa();
+    for (int i = 0; i < rows; i++)
+        ArgmaxRow(isa, data + static_cast<size_t>(i) * cols, cols, index[i], value[i]);
+}
+
+int SelectAbove(const float *row, int n, float thresh, int *index) {
+    return n > 0 ? SelectAbove(ActiveIsa(), row, n, thresh, index) : 0;
+}
+
+} // namespace ocr
@@ -0,0 +1,36 @@
+#pragma once
+#include "opencv2/core.hpp"
+
+namespace ocr {
+
+// Các kernel SIMD cho tiền / hậu xử lý detection và decode recognition (AVX2 / SSE2 chọn lúc chạy, fallback scalar).
+
+// Kernel tiền xử lý gộp cho detection: đọc trực tiếp ảnh nguồn BGR uint8,
+// resize bilinear về new_w x new_h, đặt vào khung dst_w x dst_h tại (pad_left, pad_top),
+// chuẩn hóa (x / 255 - mean) * scale và ghi thẳng theo layout NCHW vào dst.
+// Vùng padding được điền giá trị chuẩn hóa của pixel 0 (giống copyMakeBorder + chuẩn hóa).
+// dst phải có ít nhất 3 * dst_w * dst_h phần tử.
+// Tự chọn nhánh AVX2 / SSE2 lúc chạy, fallback sang vòng lặp scalar.
+void LetterboxNormalizeNCHW(const cv::Mat &src, int new_w, int new_h,
+                            int dst_w, int dst_h, int pad_left, int pad_top,
+                            const float mean[3], const float scale[3], float *dst);
+
+// Nhị phân hóa bản đồ xác suất h x w và (tùy chọn) giãn nở 2x2 trong một lượt, ghi vào bitmap (CV_8UC1, 0/255).
+// Kết quả trùng từng bit với cách cũ: cbuf = (uchar)(p * 255), cv::threshold(cbuf, THRESH_BINARY, thresh * 255)
+// rồi cv::dilate với MORPH_RECT 2x2, anchor mặc định (mỗi điểm lấy max của chính nó, trái, trên, trên-trái).
+// bitmap được cấp phát lại chỉ khi đổi kích thước; bộ đệm hàng dùng lại theo luồng.
+void ThresholdDilateBitmap(const float *prob, int h, int w, double thresh, bool dilate, cv::Mat &bitmap);
+
+// Argmax theo hàng của ma trận rows x cols (ví dụ output recognition [seq_len, num_classes]):
+// index[i] / value[i] nhận vị trí và giá trị lớn nhất của hàng i. Khi có nhiều phần tử bằng nhau,
+// chọn vị trí nhỏ nhất (giống vòng lặp scalar so sánh >).
+void ArgmaxRows(const float *data, int rows, int cols, int *index, float *value);
+
+// Ghi vị trí (tăng dần) của mọi phần tử row[j] >= thresh vào index (cần đủ n phần tử), trả về số vị trí.
+// Dùng để lọc các lớp đáng kể của một bước output recognition cho beam search.
+int SelectAbove(const float *row, int n, float thresh, int *index);
+
+// Tên nhánh SIMD đang được dùng ("avx2", "sse2" hoặc "scalar"), tiện cho log/benchmark.
+const char *SimdKernelIsa();
+
+} // namespace ocr
@@ -0,0 +1,178 @@
+#include "text_crop.h"
+#include "opencv2/imgproc.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace ocr {
+
+namespace {
+
+const float kInv255 = 1.f / 255.f;
+
+// Tọa độ trên ảnh crop crop_len của pixel i khi resize về dst_len (quy ước INTER_LINEAR của cv::resize).
+inline float ResizeCoord(int i, int crop_len, int dst_len) {
+    float x = (i + 0.5f) * crop_len / dst_len - 0.5f;
+    return std::min(std::max(x, 0.f), static_cast<float>(crop_len - 1));
+}
+
+// Lấy mẫu bilinear một điểm (x, y) của ảnh BGR uint8, tọa độ ngoài ảnh được kẹp về biên.
+inline void SampleBilinear(const cv::Mat &src, float x, float y, float out[3]) {
+    x = std::min(std::max(x, 0.f), static_cast<float>(src.cols - 1));
+    y = std::min(std::max(y, 0.f), static_cast<float>(src.rows - 1));
+    int x0 = static_cast<int>(x), y0 = static_cast<int>(y);
+    int x1 = std::min(x0 + 1, src.cols - 1), y1 = std::min(y0 + 1, src.rows - 1);
+    float ax = x - x0, ay = y - y0;
+    const unsigned char *r0 = src.ptr<unsigned char>(y0);
+    const unsigned char *r1 = src.ptr<unsigned char>(y1);
+    for (int c = 0; c < 3; c++) {
+        float top = r0[x0 * 3 + c] + ax * (r0[x1 * 3 + c] - r0[x0 * 3 + c]);
+        float bottom = r1[x0 * 3 + c] + ax * (r1[x1 * 3 + c] - r1[x0 * 3 + c]);
+        out[c] = top + ay * (bottom - top);
+    }
+}
+
+// Nhánh tách được: tọa độ nguồn của cột u chỉ phụ thuộc u (xs[u]), của hàng v chỉ phụ thuộc v (ys[v]).
+void SampleSeparable(const cv::Mat &src, const std::vector<float> &xs, const std::vector<float> &ys,
+                     int dst_h, int dst_w, int row_stride, float *dst) {
+    thread_local std::vector<int> x0s, x1s;
+    thread_local std::vector<float> axs;
+    x0s.resize(dst_w);
+    x1s.resize(dst_w);
+    axs.resize(dst_w);
+    for (int u = 0; u < dst_w; u++) {
+        float x = std::min(std::max(xs[u], 0.f), static_cast<float>(src.cols - 1));
+        x0s[u] = static_cast<int>(x);
+        x1s[u] = std::min(x0s[u] + 1, src.cols - 1);
+        axs[u] = x - x0s[u];
+        x0s[u] *= 3;
+        x1s[u] *= 3;
+    }
+    const size_t plane = static_cast<size_t>(dst_h) * row_stride;
+    for (int v = 0; v < dst_h; v++) {
+        float y = std::min(std::max(ys[v], 0.f), static_cast<float>(src.rows - 1));
+        int y0 = static_cast<int>(y);
+        int y1 = std::min(y0 + 1, src.rows - 1);
+        float ay = y - y0;
+        const unsigned char *r0 = src.ptr<unsigned char>(y0);
+        const unsigned char *r1 = src.ptr<unsigned char>(y1);
+        float *out = dst + static_cast<size_t>(v) * row_stride;
+        for (int u = 0; u < dst_w; u++) {
+            const int a = x0s[u], b = x1s[u];
+            const float ax = axs[u];
+            for (int c = 0; c < 3; c++) {
+                float top = r0[a + c] + ax * (r0[b + c] - r0[a + c]);
+                float bottom = r1[a + c] + ax * (r1[b + c] - r1[a + c]);
+                out[c * plane + u] = (top + ay * (bottom - top)) * kInv255;
+            }
+        }
+    }
+}
+
+} // namespace
+
+cv::Size CropSize(const Quad &box) {
+    const QuadPoint *p = box.pts;
+    float width = std::max(std::hypot(p[0].x - p[1].x, p[0].y - p[1].y),
+                           std::hypot(p[2].x - p[3].x, p[2].y - p[3].y));
+    float height = std::max(std::hypot(p[0].x - p[3].x, p[0].y - p[3].y),
+                            std::hypot(p[1].x - p[2].x, p[1].y - p[2].y));
+    return cv::Size(static_cast<int>(width), static_cast<int>(height));
+}
+
+Quad SubQuad(const Quad &box, float t0, float t1) {
+    const QuadPoint *p = box.pts;
+    auto lerp = [](const QuadPoint &a, const QuadPoint &b, float t) {
+        return QuadPoint{a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t};
+    };
+    Quad sub = box;
+    sub.pts[0] = lerp(p[0], p[1], t0);
+    sub.pts[1] = lerp(p[0], p[1], t1);
+    sub.pts[2] = lerp(p[3], p[2], t1);
+    sub.pts[3] = lerp(p[3], p[2], t0);
+    return sub;
+}
+
+int RecInputWidth(const cv::Size &crop_size, int dst_h) {
+    if (crop_size.width <= 0 || crop_size.height <= 0)
+        return 0;
+    return static_cast<int>(crop_size.width * (dst_h / static_cast<float>(crop_size.height)));
+}
+
+void CropResizeToTensor(const cv::Mat &src, const Quad &box, int dst_h, int dst_w, float *dst, int row_stride) {
+    if (row_stride <= 0)
+        row_stride = dst_w;
+    const QuadPoint *p = box.pts;
+    const cv::Size crop = CropSize(box);
+    // Như CropBox: góc box ánh xạ tới (0, 0), (W - 1, 0), (W - 1, H - 1), (0, H - 1) của ảnh crop.
+    const float span_w = static_cast<float>(crop.width - 1);
+    const float span_h = static_cast<float>(crop.height - 1);
+
+    thread_local std::vector<float> xs, ys;
+    xs.resize(dst_w);
+    ys.resize(dst_h);
+
+    const bool axis_aligned = std::fabs(p[0].y - p[1].y) <= 0.5f && std::fabs(p[3].y - p[2].y) <= 0.5f &&
+                              std::fabs(p[0].x - p[3].x) <= 0.5f && std::fabs(p[1].x - p[2].x) <= 0.5f;
+    if (axis_aligned) {
+        // Phép chiếu suy biến thành scale + tịnh tiến riêng cho từng trục.
+        const float left = 0.5f * (p[0].x + p[3].x), right = 0.5f * (p[1].x + p[2].x);
+        const float top = 0.5f * (p[0].y + p[1].y), bottom = 0.5f * (p[3].y + p[2].y);
+        const float sx = span_w > 0.f ? (right - left) / span_w : 0.f;
+        const float sy = span_h > 0.f ? (bottom - top) / span_h : 0.f;
+        for (int u = 0; u < dst_w; u++)
+            xs[u] = left + ResizeCoord(u, crop.width, dst_w) * sx;
+        for (int v = 0; v < dst_h; v++)
+            ys[v] = top + ResizeCoord(v, crop.height, dst_h) * sy;
+        SampleSeparable(src, xs, ys, dst_h, dst_w, row_stride, dst);
+        return;
+    }
+
+    // Phép chiếu từ ảnh crop về ảnh nguồn (nghịch đảo của ma trận CropBox dùng cho warpPerspective).
+    const cv::Point2f crop_pts[4] = {cv::Point2f(0.f, 0.f), cv::Point2f(span_w, 0.f),
+                                     cv::Point2f(span_w, span_h), cv::Point2f(0.f, span_h)};
+    const cv::Point2f src_pts[4] = {cv::Point2f(p[0].x, p[0].y), cv::Point2f(p[1].x, p[1].y),
+                                    cv::Point2f(p[2].x, p[2].y), cv::Point2f(p[3].x, p[3].y)};
+    cv::Mat m = cv::getPerspectiveTransform(crop_pts, src_pts);
+    double h[9];
+    for (int i = 0; i < 9; i++)
+        h[i] = m.at<double>(i / 3, i % 3);
+
+    for (int u = 0; u < dst_w; u++)
+        xs[u] = ResizeCoord(u, crop.width, dst_w);
+    for (int v = 0; v < dst_h; v++)
+        ys[v] = ResizeCoord(v, crop.height, dst_h);
+
+    const size_t plane = static_cast<size_t>(dst_h) * row_stride;
+    float value[3];
+    for (int v = 0; v < dst_h; v++) {
+        const double cy = ys[v];
+        // Phần phụ thuộc hàng của tử số / mẫu số, cộng dần theo cột.
+        const double bx = h[1] * cy + h[2], by = h[4] * cy + h[5], bw = h[7] * cy + h[8];
+        float *out = dst + static_cast<size_t>(v) * row_stride;
+        for (int u = 0; u < dst_w; u++) {
+            const double cx = xs[u];
+            const double w = h[6] * cx + bw;
+            const double inv = w != 0.0 ? 1.0 / w : 0.0;
+            SampleBilinear(src, static_cast<float>((h[0] * cx + bx) * inv),
+                           static_cast<float>((h[3] * cx + by) * inv), value);
+            for (int c = 0; c < 3; c++)
+                out[c * plane + u] = value[c] * kInv255;
+        }
+    }
+}
+
+void ResizeToTensor(const cv::Mat &src, int dst_h, int dst_w, float *dst, int row_stride) {
+    if (row_stride <= 0)
+        row_stride = dst_w;
+    thread_local std::vector<float> xs, ys;
+    xs.resize(dst_w);
+    ys.resize(dst_h);
+    for (int u = 0; u < dst_w; u++)
+        xs[u] = ResizeCoord(u, src.cols, dst_w);
+    for (int v = 0; v < dst_h; v++)
+        ys[v] = ResizeCoord(v, src.rows, dst_h);
+    SampleSeparable(src, xs, ys, dst_h, dst_w, row_stride, dst);
+}
+
+} // namespace ocr
@@ -0,0 +1,29 @@
+#pragma once
+#include "opencv2/core.hpp"
+#include "quad.h"
+
+namespace ocr {
+
+// Kích thước ảnh crop của box theo CropBox (cạnh dài nhất của mỗi cặp cạnh đối, làm tròn xuống).
+cv::Size CropSize(const Quad &box);
+
+// Phần [t0, t1] (tỷ lệ theo chiều rộng, 0 = cạnh trái) của box: nội suy dọc cạnh trên (tl -> tr) và
+// cạnh dưới (bl -> br).
+Quad SubQuad(const Quad &box, float t0, float t1);
+
+// Chiều rộng input recognition khi ảnh crop crop_size được resize về chiều cao dst_h (giữ tỷ lệ).
+int RecInputWidth(const cv::Size &crop_size, int dst_h);
+
+// Crop box + resize + chuẩn hóa trong một lượt: mỗi pixel của tensor dst (3 x dst_h x dst_w, NCHW,
+// kênh BGR, giá trị / 255) được lấy mẫu bilinear trực tiếp từ src (BGR uint8) qua phép biến đổi
+// gộp "perspective của box" o "resize về dst_h x dst_w", thay cho CropBox + cv::resize + convertTo
+// + cv::split + memcpy. Box gần như thẳng trục (lệch <= 0.5 pixel) đi nhánh nhanh tách được theo
+// hàng / cột, không cần tính phép chiếu cho từng pixel. Điểm ngoài ảnh lấy theo pixel biên gần nhất.
+// row_stride > dst_w: ghi vào phần trái của tensor rộng hơn (mỗi kênh dst_h x row_stride), phần còn lại
+// của mỗi hàng không bị đụng tới (dùng khi pad nhiều crop vào cùng một batch).
+void CropResizeToTensor(const cv::Mat &src, const Quad &box, int dst_h, int dst_w, float *dst, int row_stride = 0);
+
+// Như CropResizeToTensor nhưng với toàn bộ ảnh src (tương đương cv::resize về dst_w x dst_h + / 255).
+void ResizeToTensor(const cv::Mat &src, int dst_h, int dst_w, float *dst, int row_stride = 0);
+
+} // namespace ocr
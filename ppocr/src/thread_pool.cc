@@ -0,0 +1,113 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace ocr {
+
+ThreadPool::ThreadPool(int num_threads) {
+    for (int i = 0; i < num_threads; i++) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : workers_) {
+        t.join();
+    }
+}
+
+ThreadPool &ThreadPool::Shared() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+int ThreadPool::size() const { return static_cast<int>(workers_.size()); }
+
+int ThreadPool::maxSlots() const { return size() + 1; }
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+            if (stop_ && tasks_.empty())
+                return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(int n, const std::function<void(int index, int slot)> &fn) {
+    if (n <= 0)
+        return;
+    if (workers_.empty() || n == 1) {
+        for (int i = 0; i < n; i++)
+            fn(i, 0);
+        return;
+    }
+
+    // Trạng thái chung của một lần parallelFor. Các task phụ có thể bắt đầu sau khi luồng gọi
+    // đã xử lý hết và trả về, khi đó chúng chỉ thấy next >= n và thoát mà không chạm vào fn.
+    struct State {
+        std::atomic<int> next{0};
+        std::atomic<int> done{0};
+        std::atomic<int> slots{1};
+        int n = 0;
+        const std::function<void(int, int)> *fn = nullptr;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->n = n;
+    state->fn = &fn;
+
+    auto run = [](const std::shared_ptr<State> &st, int slot) {
+        int i;
+        while ((i = st->next.fetch_add(1)) < st->n) {
+            try {
+                (*st->fn)(i, slot);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(st->mutex);
+                if (!st->error)
+                    st->error = std::current_exception();
+            }
+            if (st->done.fetch_add(1) + 1 == st->n) {
+                std::lock_guard<std::mutex> lock(st->mutex);
+                st->cv.notify_all();
+            }
+        }
+    };
+
+    int helpers = std::min(n - 1, size());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int h = 0; h < helpers; h++) {
+            tasks_.emplace_back([state, run] {
+                if (state->next.load() >= state->n)
+                    return;
+                run(state, state->slots.fetch_add(1));
+            });
+        }
+    }
+    cv_.notify_all();
+
+    run(state, 0);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&] { return state->done.load() == n; });
+    if (state->error)
+        std::rethrow_exception(state->error);
+}
+
+} // namespace ocr
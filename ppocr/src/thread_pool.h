@@ -0,0 +1,47 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ocr {
+
+// Pool luồng cố định, dùng chung cho các bước có thể chạy song song (tile detection, hậu xử lý,...).
+class ThreadPool {
+public:
+    // num_threads: số luồng worker (0 = chạy tuần tự trên luồng gọi).
+    explicit ThreadPool(int num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Pool dùng chung toàn tiến trình (hardware_concurrency - 1 worker), tạo ở lần gọi đầu tiên.
+    static ThreadPool &Shared();
+
+    // Số luồng worker.
+    int size() const;
+
+    // Số slot tối đa mà parallelFor có thể dùng đồng thời (worker + luồng gọi).
+    int maxSlots() const;
+
+    // Chạy fn(index, slot) cho mọi index trong [0, n) và chờ đến khi xong.
+    // Luồng gọi cũng tham gia xử lý nên gọi lồng nhau từ bên trong worker không bị deadlock.
+    // slot nằm trong [0, maxSlots()) và không trùng giữa các lần gọi fn đang chạy đồng thời
+    // của cùng một parallelFor, dùng để chọn bộ đệm / predictor riêng.
+    // Ngoại lệ đầu tiên phát sinh trong fn được ném lại ở luồng gọi.
+    void parallelFor(int n, const std::function<void(int index, int slot)> &fn);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+};
+
+} // namespace ocr
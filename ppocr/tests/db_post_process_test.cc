@@ -0,0 +1,180 @@
+// Kiểm tra hậu xử lý DB không cần mô hình:
+//  - hai bộ trích box của BoxesFromBitmap (det_box_extractor 0 = findContours, 1 = BoxesFromComponents) trên
+//    một bản đồ xác suất tổng hợp dày đặc: đo thời gian và kiểm tra hai tập box trùng nhau;
+//  - UnclipRectangle (dạng đóng) so với đường ClipperOffset cũ (UnclipPolygon) trên các hình chữ nhật xoay
+//    ngẫu nhiên: lệch không quá ~2 px.
+// Trả về 0 nếu mọi kiểm tra đạt.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "db_post_process.h"
+#include "simd_kernels.h"
+
+namespace {
+
+// Bản đồ xác suất giống output DB của một trang chữ dày đặc: các dòng cách nhau 28 px, mỗi dòng gồm các
+// đoạn chữ rộng 40..200 px, cao 10..16 px, một phần nghiêng tới 2 độ (hai dòng kề nhau vẫn không chạm nhau
+// sau giãn nở); nền 0.05, chữ 0.85..0.95.
+// Các đoạn là hình chữ nhật đặc, không có lỗ: findContours (RETR_LIST) trả cả contour trong của lỗ, còn
+// BoxesFromComponents chỉ lấy bao lồi của thành phần, nên hai bộ trích chỉ trùng nhau trên vùng không lỗ.
+cv::Mat DensePredMap(int size, unsigned seed, int &num_segments) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> seg_width(40, 200), seg_height(10, 16), gap(16, 40), tilted(0, 3);
+    std::uniform_real_distribution<float> angle(-2.f, 2.f), prob(0.85f, 0.95f);
+    cv::Mat pred(size, size, CV_32F, cv::Scalar(0.05f));
+    num_segments = 0;
+    for (int y = 20; y + 20 < size; y += 28) {
+        for (int x = gap(rng); ;) {
+            const int w = seg_width(rng);
+            if (x + w + 20 > size)
+                break;
+            const float a = tilted(rng) == 0 ? angle(rng) : 0.f;
+            cv::RotatedRect rect(cv::Point2f(x + w / 2.f, static_cast<float>(y)),
+                                 cv::Size2f(static_cast<float>(w), static_cast<float>(seg_height(rng))), a);
+            cv::Point2f corners[4];
+            rect.points(corners);
+            std::vector<cv::Point> poly;
+            for (const cv::Point2f &p : corners)
+                poly.emplace_back(cvRound(p.x), cvRound(p.y));
+            cv::fillPoly(pred, std::vector<std::vector<cv::Point>>{poly}, cv::Scalar(prob(rng)));
+            num_segments++;
+            x += w + gap(rng);
+        }
+    }
+    return pred;
+}
+
+float Distance(const cv::Point2f &a, const cv::Point2f &b) {
+    return std::hypot(a.x - b.x, a.y - b.y);
+}
+
+float CornerDistance(const ocr::Quad &a, const ocr::Quad &b) {
+    float worst = 0.f;
+    for (int i = 0; i < 4; i++)
+        worst = std::max(worst, std::hypot(a.pts[i].x - b.pts[i].x, a.pts[i].y - b.pts[i].y));
+    return worst;
+}
+
+// Số box của a có box tương ứng (chưa dùng) trong b: mỗi đỉnh lệch không quá 1 px, điểm lệch không quá 1e-4.
+int MatchedBoxes(const std::vector<ocr::Quad> &a, const std::vector<ocr::Quad> &b) {
+    std::vector<bool> used(b.size(), false);
+    int matched = 0;
+    for (const ocr::Quad &box : a) {
+        for (size_t j = 0; j < b.size(); j++) {
+            if (!used[j] && CornerDistance(box, b[j]) <= 1.f && std::fabs(box.score - b[j].score) <= 1e-4f) {
+                used[j] = true;
+                matched++;
+                break;
+            }
+        }
+    }
+    return matched;
+}
+
+// Thời gian trung vị (ms) của một lần BoxesFromBitmap với bộ trích extractor.
+double TimeExtractor(const cv::Mat &pred, const cv::Mat &bitmap, std::map<std::string, double> config,
+                     int extractor, int repeats, std::vector<ocr::Quad> &boxes) {
+    config["det_box_extractor"] = extractor;
+    std::vector<double> ms;
+    for (int r = 0; r < repeats; r++) {
+        const auto start = std::chrono::steady_clock::now();
+        boxes = BoxesFromBitmap(pred, bitmap, config);
+        ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(ms.begin(), ms.end());
+    return ms[ms.size() / 2];
+}
+
+// Độ lệch lớn nhất (tâm, cạnh, góc) giữa UnclipRectangle và UnclipPolygon trên count hình chữ nhật xoay
+// ngẫu nhiên lấy qua GetMiniQuad như box thật, với khoảng nở của GetContourArea theo unclip_ratio.
+struct UnclipDiff {
+    float center = 0.f;
+    float side = 0.f;
+    float corner = 0.f;
+};
+
+UnclipDiff CompareUnclip(int count, float unclip_ratio, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> pos(50.f, 650.f), width(10.f, 300.f), height(4.f, 60.f),
+        angle(-90.f, 90.f);
+    UnclipDiff diff;
+    for (int i = 0; i < count; i++) {
+        float ssid;
+        const ocr::Quad box =
+            GetMiniQuad(cv::RotatedRect(cv::Point2f(pos(rng), pos(rng)), cv::Size2f(width(rng), height(rng)),
+                                        angle(rng)),
+                        ssid);
+        float distance;
+        GetContourArea(box, unclip_ratio, distance);
+        const cv::RotatedRect fast = UnclipRectangle(box, distance);
+        const cv::RotatedRect clipper = UnclipPolygon(box, distance);
+
+        diff.center = std::max(diff.center, Distance(fast.center, clipper.center));
+        // So cạnh ngắn với cạnh ngắn, dài với dài: hai bên có thể đặt width/height và góc khác nhau 90 độ.
+        const float fast_short = std::min(fast.size.width, fast.size.height);
+        const float fast_long = std::max(fast.size.width, fast.size.height);
+        const float clipper_short = std::min(clipper.size.width, clipper.size.height);
+        const float clipper_long = std::max(clipper.size.width, clipper.size.height);
+        diff.side = std::max(diff.side, std::max(std::fabs(fast_short - clipper_short),
+                                                 std::fabs(fast_long - clipper_long)));
+        // Góc được so qua các đỉnh: mỗi đỉnh của một bên tới đỉnh gần nhất của bên kia.
+        cv::Point2f fast_pts[4], clipper_pts[4];
+        fast.points(fast_pts);
+        clipper.points(clipper_pts);
+        for (const cv::Point2f &p : fast_pts) {
+            float nearest = Distance(p, clipper_pts[0]);
+            for (const cv::Point2f &q : clipper_pts)
+                nearest = std::min(nearest, Distance(p, q));
+            diff.corner = std::max(diff.corner, nearest);
+        }
+    }
+    return diff;
+}
+
+bool Check(bool ok, const char *what) {
+    std::printf("%s: %s\n", ok ? "OK  " : "FAIL", what);
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+
+    // Hai bộ trích box trên cùng một bitmap dày đặc (nhị phân hóa + giãn nở như DetProcess::PostprocessMap).
+    std::map<std::string, double> config;
+    config["det_db_box_thresh"] = 0.5;
+    config["det_db_unclip_ratio"] = 1.5;
+    config["det_use_polygon_score"] = 0;
+    int num_segments = 0;
+    const cv::Mat pred = DensePredMap(1280, 1, num_segments);
+    cv::Mat bitmap;
+    ocr::ThresholdDilateBitmap(pred.ptr<float>(), pred.rows, pred.cols, 0.3, true, bitmap);
+
+    std::vector<ocr::Quad> contour_boxes, component_boxes;
+    const double contour_ms = TimeExtractor(pred, bitmap, config, 0, 20, contour_boxes);
+    const double component_ms = TimeExtractor(pred, bitmap, config, 1, 20, component_boxes);
+    std::printf("%d đoạn chữ: findContours %zu box, %.2f ms; BoxesFromComponents %zu box, %.2f ms\n", num_segments,
+                contour_boxes.size(), contour_ms, component_boxes.size(), component_ms);
+    ok &= Check(static_cast<int>(contour_boxes.size()) == num_segments, "findContours tìm đủ mọi đoạn chữ");
+    ok &= Check(contour_boxes.size() == component_boxes.size() &&
+                    MatchedBoxes(contour_boxes, component_boxes) == static_cast<int>(contour_boxes.size()),
+                "hai bộ trích cho cùng tập box (đỉnh lệch <= 1 px, cùng điểm)");
+
+    // UnclipRectangle so với đường Clipper cũ: đỉnh bị cắt về số nguyên trước khi offset và lưới offset nguyên
+    // làm lệch tới ~2 px; giới hạn dưới đây có dư một chút so với đo được.
+    for (float ratio : {1.0f, 1.5f, 2.0f}) {
+        const UnclipDiff diff = CompareUnclip(5000, ratio, 2);
+        std::printf("unclip_ratio %.1f: lệch tâm %.2f px, cạnh %.2f px, đỉnh %.2f px\n", ratio, diff.center,
+                    diff.side, diff.corner);
+        ok &= Check(diff.center <= 2.f && diff.side <= 3.f && diff.corner <= 4.f,
+                    "UnclipRectangle khớp đường Clipper (tâm <= 2 px, cạnh <= 3 px, đỉnh <= 4 px)");
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+// Kiểm tra ghép đoạn của dòng dài (rec_chunks.h) không cần mô hình: đường argmax CTC tổng hợp của cả dòng
+// được so với đường ghép từ các đoạn chồng lấn (cùng ChunkOffsets / StitchChunks mà RecProcess dùng), sau
+// khi gộp bằng CollapsePath. Trả về 0 nếu mọi kiểm tra đạt.
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "ctc_decoder.h"
+#include "rec_chunks.h"
+
+namespace {
+
+using namespace ocr;
+
+// Cùng tham số mặc định với RecProcess::recognizeBatch (rec_max_chunk_width, rec_chunk_overlap) và bước
+// output của mô hình recognition (8 cột input mỗi bước).
+constexpr int kChunkWidth = 960;
+constexpr int kOverlap = 96;
+constexpr float kStepWidth = 8.f;
+
+struct Piece {
+    int offset;
+    int width;
+    float step_width;
+};
+
+// Một ký tự trên dòng: lớp và khoảng cột input [x0, x1).
+struct Glyph {
+    int label;
+    int x0;
+    int x1;
+};
+
+// Dòng ngẫu nhiên rộng khoảng width cột: ký tự rộng 12..30 cột, cách nhau 8..16 cột, khoảng trắng giữa hai
+// từ 24..40 cột (trung bình sau mỗi 6 ký tự). Khoảng cách không nhỏ hơn một bước nên luôn có bước blank giữa
+// hai ký tự dù lưới bước đặt ở đâu (như output thật của mô hình; nếu không, hai ký tự giống nhau liền nhau
+// bị gộp trên lưới này mà không bị gộp trên lưới khác).
+std::vector<Glyph> RandomLine(std::mt19937 &rng, int width, int num_classes) {
+    std::uniform_int_distribution<int> label(1, num_classes - 1), glyph(12, 30), gap(8, 16), space(24, 40);
+    std::uniform_int_distribution<int> word_end(0, 5);
+    std::vector<Glyph> line;
+    for (int x = gap(rng); ;) {
+        const int w = glyph(rng);
+        if (x + w > width - 4)
+            break;
+        line.push_back(Glyph{label(rng), x, x + w});
+        x += w + (word_end(rng) == 0 ? space(rng) : gap(rng));
+    }
+    return line;
+}
+
+// Đường argmax của đoạn bắt đầu ở cột offset, rộng width: bước t thuộc ký tự chứa tâm của nó (dịch shift
+// bước, mô phỏng căn chỉnh lệch của đoạn thấy ngữ cảnh khác), ngược lại blank.
+CtcPath RenderPath(const std::vector<Glyph> &line, int offset, int width, int shift) {
+    CtcPath path;
+    const int steps = static_cast<int>(width / kStepWidth);
+    const int first_step = static_cast<int>(offset / kStepWidth);
+    for (int t = 0; t < steps; t++) {
+        const float center = offset + (t + shift + 0.5f) * kStepWidth;
+        int index = 0;
+        for (const Glyph &g : line) {
+            if (center >= g.x0 && center < g.x1) {
+                index = g.label;
+                break;
+            }
+        }
+        path.index.push_back(index);
+        path.prob.push_back(1.f);
+        path.step.push_back(first_step + t);
+    }
+    return path;
+}
+
+// Tỷ lệ dòng (trên count dòng ngẫu nhiên) mà text ghép từ các đoạn trùng text của cả dòng. max_shift > 0:
+// mỗi đoạn lệch ngẫu nhiên trong [-max_shift, max_shift] bước.
+double StitchAgreement(int count, int max_shift, unsigned seed) {
+    std::vector<std::string> char_list = {"#"};
+    for (char c = 'a'; c <= 'z'; c++)
+        char_list.push_back(std::string(1, c));
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> line_width(kChunkWidth + 200, 4 * kChunkWidth), shift(-max_shift, max_shift);
+    int agree = 0;
+    for (int i = 0; i < count; i++) {
+        const int width = line_width(rng);
+        const std::vector<Glyph> line = RandomLine(rng, width, static_cast<int>(char_list.size()));
+        const std::string expected = CollapsePath(RenderPath(line, 0, width, 0), char_list).text;
+
+        std::vector<Piece> pieces;
+        std::vector<CtcPath> parts;
+        for (int offset : ChunkOffsets(width, kChunkWidth, kOverlap)) {
+            pieces.push_back(Piece{offset, kChunkWidth, kStepWidth});
+            parts.push_back(RenderPath(line, offset, kChunkWidth, max_shift > 0 ? shift(rng) : 0));
+        }
+        const std::string stitched = CollapsePath(StitchChunks(pieces, parts, 0, pieces.size()), char_list).text;
+        if (stitched == expected)
+            agree++;
+    }
+    return static_cast<double>(agree) / count;
+}
+
+bool Check(bool ok, const char *what) {
+    std::printf("%s: %s\n", ok ? "OK  " : "FAIL", what);
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+
+    // Các đoạn phủ cả dòng, đều rộng kChunkWidth và chồng lấn ít nhất kOverlap cột.
+    for (int width : {kChunkWidth + 1, 1500, 2000, 3333, 4 * kChunkWidth}) {
+        const std::vector<int> offsets = ChunkOffsets(width, kChunkWidth, kOverlap);
+        bool covered = offsets.front() == 0 && offsets.back() + kChunkWidth == width;
+        for (size_t k = 1; k < offsets.size(); k++)
+            covered = covered && offsets[k - 1] + kChunkWidth - offsets[k] >= kOverlap;
+        ok &= Check(covered, ("ChunkOffsets phủ dòng rộng " + std::to_string(width)).c_str());
+    }
+
+    // Đoạn căn chỉnh đúng: ghép phải cho đúng text của cả dòng.
+    const double exact = StitchAgreement(500, 0, 1);
+    std::printf("không lệch: %.1f%% dòng khớp\n", 100.0 * exact);
+    ok &= Check(exact == 1.0, "ghép đoạn căn chỉnh đúng khớp nhận dạng cả dòng");
+
+    // Mỗi đoạn lệch tối đa một bước: độ lệch được ước lượng lại khi nối.
+    const double shifted = StitchAgreement(500, 1, 2);
+    std::printf("lệch +-1 bước: %.1f%% dòng khớp\n", 100.0 * shifted);
+    ok &= Check(shifted >= 0.95, "ghép đoạn lệch +-1 bước khớp >= 95% dòng");
+
+    return ok ? 0 : 1;
+}
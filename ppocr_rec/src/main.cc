@@ -5,6 +5,7 @@
 #include <cstring>
 #include <opencv2/opencv.hpp>
 #include "paddle_api.h"
+#include "simd_kernels.h"
 
 using namespace paddle::lite_api;
 
@@ -25,31 +26,25 @@ std::vector<std::string> load_char_dict(const std::string& dict_path) {
     }
     return char_list;
 }
-// Hàm giải mã CTC
+// Hàm giải mã CTC: argmax từng bước bằng kernel SIMD (ocr::ArgmaxRows) đọc thẳng từ output tensor.
 DecodeResult ctc_greedy_decoder(const float* probs, int seq_len, int num_classes, const std::vector<std::string>& char_list) {
     DecodeResult result;
-    result.text = "";
+    std::vector<int> max_index(seq_len);
+    std::vector<float> max_val(seq_len);
+    ocr::ArgmaxRows(probs, seq_len, num_classes, max_index.data(), max_val.data());
+    result.text.reserve(seq_len * 3);  // ký tự UTF-8 của từ điển dài tối đa 3 byte
     float confidence_sum = 0.f;
     int count = 0;
     int prev_index = -1;
     for (int i = 0; i < seq_len; ++i) {
-        int max_index = 0;
-        float max_val = probs[i * num_classes];
-        for (int j = 1; j < num_classes; j++) {
-            float val = probs[i * num_classes + j];
-            if (val > max_val) {
-                max_val = val;
-                max_index = j;
-            }
-        }
-        if (max_index != 0 && max_index != prev_index) {
-            if (max_index < char_list.size()) {
-                result.text += char_list[max_index];
-                confidence_sum += max_val;
+        if (max_index[i] != 0 && max_index[i] != prev_index) {
+            if (max_index[i] < static_cast<int>(char_list.size())) {
+                result.text += char_list[max_index[i]];
+                confidence_sum += max_val[i];
                 count++;
             }
         }
-        prev_index = max_index;
+        prev_index = max_index[i];
     }
     result.confidence = (count > 0) ? (confidence_sum / count) : 0.f;
     return result;